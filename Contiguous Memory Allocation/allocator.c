@@ -1,54 +1,67 @@
 /**
  * @file allocator.c
- * @brief Contiguous Memory Allocator
+ * @brief Contiguous Memory Allocator library
  * 
- * This program implements a dynamic memory manager that simulates contiguous
- * memory allocation. It supports three allocation strategies:
+ * This library implements a dynamic memory manager that simulates contiguous
+ * memory allocation. It supports these allocation strategies:
  * - First Fit (F): Allocate from the first hole large enough
  * - Best Fit (B): Allocate from the smallest hole large enough
  * - Worst Fit (W): Allocate from the largest available hole
+ * - Buddy (Y): Allocate a power-of-two block aligned to its own size
+ * - TLSF (T): Two-level segregated fit with constant-time lookups
  * 
  * Features:
  * - Memory allocation and release with automatic hole merging
  * - Compaction to consolidate all free memory
  * - Fragmentation metrics and statistics
  * - Visual memory map output
- * - Batch command execution from file
+ * - Independent instances behind an opaque handle (see allocator.h)
+ * - Batches of requests and releases applied in one call
+ * - Snapshots of the whole state that load by mapping the file
  * 
  * @author Gabriel Giancarlo
  * @date 2025
  */
 
-#include <stdio.h>
+#define _POSIX_C_SOURCE 200809L
+
+#include "allocator.h"
+
 #include <stdlib.h>
 #include <string.h>
-#include <stdbool.h>
 #include <limits.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 /* ============================================================================
  * CONSTANTS AND MACROS
  * ============================================================================ */
 
-#define MAX_PROCESSES 1000
-#define MAX_LINE_LENGTH 256
-#define MAX_PROCESS_NAME_LENGTH 64
-#define VISUALIZATION_WIDTH 50
+#define MAX_PROCESS_NAME_LENGTH ALLOCATOR_MAX_NAME_LENGTH
+#define SIZE_CLASS_COUNT 64          ///< One segregated hole class per power of two
+#define NAME_TABLE_MIN_CAPACITY 64   ///< Initial slot count of the process name table
+#define BLOCK_POOL_SLAB_SIZE 1024    ///< MemoryBlock nodes carved from each pool slab
+#define TLSF_SL_LOG2 4                ///< log2 of the TLSF second-level subdivisions
+#define TLSF_SL_COUNT (1 << TLSF_SL_LOG2)
+#define TLSF_FL_COUNT (SIZE_CLASS_COUNT - TLSF_SL_LOG2 + 1)
+#define NIL_BLOCK 0                  ///< BlockId meaning "no block"
+#define NO_NAME ALLOCATOR_NO_NAME     ///< NameId of a free block
+#define OCCUPANCY_MAX_LEAVES (1 << 18) ///< Most leaves of the occupancy tree (finest map resolution)
+#define SNAPSHOT_MAGIC "CMASNAP"     ///< First 8 bytes of a snapshot file (with the NUL)
+#define SNAPSHOT_VERSION 6
+#define SIZE_TEXT_LENGTH 32          ///< Buffer for a byte count written by format_size()
+#define SNAPSHOT_ALIGNMENT 64        ///< Every array in a snapshot starts on this boundary
+#define SNAPSHOT_TEMP_SUFFIX ".tmp"  ///< Appended to a snapshot's path while it is being written
+#define SNAPSHOT_HASH_SEED 0xcbf29ce484222325ULL  ///< FNV-1a offset basis, the checksum's start value
+#define SNAPSHOT_HASH_PRIME 0x100000001b3ULL      ///< FNV-1a prime, applied per 64-bit word
 
 /* ============================================================================
  * ENUMERATIONS
  * ============================================================================ */
 
-/**
- * @enum AllocationStrategy
- * @brief Enumeration of supported allocation strategies
- */
-typedef enum {
-    STRATEGY_FIRST_FIT = 0,
-    STRATEGY_BEST_FIT,
-    STRATEGY_WORST_FIT
-} AllocationStrategy;
-
 /**
  * @enum MemoryBlockType
  * @brief Type of memory block (allocated or free)
@@ -58,219 +71,778 @@ typedef enum {
     BLOCK_FREE
 } MemoryBlockType;
 
+/**
+ * @enum SnapshotSection
+ * @brief Arrays stored in a snapshot file, in file order
+ */
+typedef enum {
+    SNAPSHOT_SLABS = 0,              ///< Every pool slab, back to back
+    SNAPSHOT_BUDDY_CHUNKS,
+    SNAPSHOT_TLSF_NEXT,
+    SNAPSHOT_TLSF_PREV,
+    SNAPSHOT_NAME_CHARS,
+    SNAPSHOT_NAME_OFFSETS,
+    SNAPSHOT_NAME_OWNERS,
+    SNAPSHOT_NAME_REQUESTED,
+    SNAPSHOT_NAME_SLOTS,
+    SNAPSHOT_SECTION_COUNT
+} SnapshotSection;
+
 /* ============================================================================
  * DATA STRUCTURES
  * ============================================================================ */
 
+typedef uint32_t BlockId;            ///< Index of a node in the block pool (1-based)
+typedef AllocatorName NameId;        ///< Index of an interned process name (1-based)
+typedef uint32_t ChunkId;            ///< Index of a buddy chunk (1-based)
+
 /**
  * @struct MemoryBlock
  * @brief Represents a contiguous region of memory (allocated or free)
+ * 
+ * Nodes link to each other by 32-bit pool ids rather than pointers, the
+ * size is derived from start/end, and the process name is an interned id,
+ * which keeps a node within a single 64-byte cache line.
  */
 typedef struct MemoryBlock {
     size_t start;                    ///< Starting address
     size_t end;                      ///< Ending address (exclusive)
-    size_t size;                     ///< Size of the block
-    MemoryBlockType type;            ///< Type: allocated or free
-    char process_name[MAX_PROCESS_NAME_LENGTH]; ///< Process name (if allocated)
-    struct MemoryBlock *next;        ///< Next block in the list
+    size_t tree_min_start;           ///< Lowest hole start in this tree subtree
+    BlockId id;                      ///< This node's own pool id
+    BlockId next;                    ///< Next block in the list
+    BlockId prev;                    ///< Previous block in the list
+    NameId name;                     ///< Interned process name (NO_NAME if free)
+    BlockId tree_left;               ///< Left child in a hole tree (if free) or address index (if allocated)
+    BlockId tree_right;              ///< Right child in a hole tree (if free) or address index (if allocated)
+    ChunkId buddy_chunks;            ///< First buddy chunk carved from this hole (if free)
+    uint8_t type;                    ///< MemoryBlockType: allocated or free
+    uint8_t tree_height;             ///< AVL height of this tree subtree
+    uint8_t align_log2;              ///< Log2 of the alignment the block was requested with (if allocated)
 } MemoryBlock;
 
+/**
+ * @struct BlockPool
+ * @brief Slab allocator that hands out MemoryBlock nodes
+ * 
+ * Nodes are carved from fixed-size slabs and recycled through a free list,
+ * so splitting and merging blocks never goes through malloc/free. A node's
+ * id encodes its slab and slot, so ids resolve to nodes in constant time.
+ */
+typedef struct BlockPool {
+    MemoryBlock **slabs;             ///< Slabs of BLOCK_POOL_SLAB_SIZE nodes each
+    size_t slab_count;               ///< Slabs allocated so far
+    size_t slab_capacity;            ///< Length of the slabs array
+    size_t slab_used;                ///< Nodes handed out from the newest slab
+    BlockId free_nodes;              ///< Recycled nodes, chained through next
+    size_t live_nodes;               ///< Nodes currently in use
+    size_t high_water;               ///< Maximum live_nodes ever reached
+    size_t mapped_slabs;             ///< Leading slabs that live in a loaded snapshot
+} BlockPool;
+
+/**
+ * @struct BuddyChunk
+ * @brief A free power-of-two block of the buddy system
+ * 
+ * Buddy chunks are not separate memory: they are the aligned power-of-two
+ * pieces that the existing holes decompose into, so F/B/W and Y share the
+ * same free space.
+ */
+typedef struct BuddyChunk {
+    size_t start;                    ///< Start address (a multiple of 2^order)
+    BlockId hole;                    ///< Hole the chunk lies in
+    ChunkId next;                    ///< Next chunk of the same order (or next free slot)
+    ChunkId prev;                    ///< Previous chunk of the same order
+    ChunkId sibling;                 ///< Next chunk carved from the same hole
+    uint8_t order;                   ///< Chunk size is 2^order bytes
+} BuddyChunk;
+
+/**
+ * @struct BuddyIndex
+ * @brief Per-order free lists of buddy chunks, for Y
+ */
+typedef struct BuddyIndex {
+    BuddyChunk *chunks;              ///< Chunk storage, indexed by ChunkId - 1
+    ChunkId chunk_count;             ///< Chunk slots handed out so far
+    ChunkId chunk_capacity;          ///< Length of the chunks array
+    ChunkId free_chunks;             ///< Recycled chunk slots, chained through next
+    ChunkId free_lists[SIZE_CLASS_COUNT]; ///< Free chunks per order
+    uint64_t order_map;              ///< Bit k set when free_lists[k] is non-empty
+    bool active;                     ///< Whether the chunk lists are being maintained
+    bool mapped;                     ///< Whether chunks lives in a loaded snapshot
+} BuddyIndex;
+
+/**
+ * @struct TlsfIndex
+ * @brief Two-level segregated fit free lists
+ * 
+ * The first level splits hole sizes by power of two and the second level
+ * splits each power of two into TLSF_SL_COUNT equal ranges. A bitmap per
+ * level makes finding a non-empty list a pair of find-first-set operations.
+ * The list links live in arrays indexed by BlockId, so the MemoryBlock
+ * layout is unchanged.
+ */
+typedef struct TlsfIndex {
+    BlockId heads[TLSF_FL_COUNT][TLSF_SL_COUNT]; ///< Hole lists per (first, second) level
+    uint64_t fl_map;                 ///< Bit f set when any list of first level f is non-empty
+    uint32_t sl_map[TLSF_FL_COUNT];  ///< Bit s set when heads[f][s] is non-empty
+    BlockId *next;                   ///< Next hole in the same list, indexed by BlockId
+    BlockId *prev;                   ///< Previous hole in the same list, indexed by BlockId
+    size_t link_capacity;            ///< Length of next and prev
+    bool active;                     ///< Whether the lists are being maintained
+    bool mapped;                     ///< Whether next and prev live in a loaded snapshot
+} TlsfIndex;
+
+/**
+ * @struct OccupancyTree
+ * @brief Segment tree of free bytes per address range, behind the memory map
+ * 
+ * The memory is split into leaf_count equal leaves (one byte each on heaps
+ * of up to OCCUPANCY_MAX_LEAVES bytes), and every node holds the free bytes
+ * of its range. A hole covering a node's whole range is recorded once at
+ * that node in pending, so filing or dropping a hole takes O(log n) and a
+ * map column is answered in O(log n). Free bytes within a partly covered
+ * leaf are taken to be spread evenly, but a part of a mixed leaf is
+ * never reported as wholly free or wholly allocated.
+ */
+typedef struct OccupancyTree {
+    int64_t *free_bytes;             ///< Free bytes under each node, excluding ancestors' pending (root is 1)
+    int32_t *pending;                ///< Holes covering the whole node not yet counted in its children
+    size_t leaf_count;               ///< Number of leaves (power of two)
+    size_t leaf_size;                ///< Bytes covered by each leaf
+    bool active;                     ///< Whether the tree is being maintained
+} OccupancyTree;
+
+/**
+ * @struct NameTable
+ * @brief Interned process names and the block each one currently owns
+ * 
+ * Every distinct name is stored once and given a small id; blocks carry the
+ * id instead of the string. An open-addressing hash maps strings to ids,
+ * and owners[] maps ids back to the allocated block.
+ */
+typedef struct NameTable {
+    char *chars;                     ///< Interned names, NUL-terminated, back to back
+    size_t chars_used;               ///< Bytes used in chars
+    size_t chars_capacity;           ///< Bytes allocated for chars
+    size_t *offsets;                 ///< Offset of each name id's string in chars
+    BlockId *owners;                 ///< Block allocated to each name id (NIL_BLOCK if none)
+    size_t *requested;               ///< Bytes each owner asked for (less than its block for Y)
+    NameId count;                    ///< Ids handed out so far, including NO_NAME
+    NameId id_capacity;              ///< Length of offsets and owners
+    NameId *slots;                   ///< Hash slots holding name ids (NO_NAME = empty)
+    size_t slot_capacity;            ///< Slot count (power of two)
+    bool mapped;                     ///< Whether the arrays live in a loaded snapshot
+} NameTable;
+
 /**
  * @struct Allocator
- * @brief Main allocator state structure
+ * @brief Main allocator state structure (opaque outside this file)
+ * 
+ * The block list is the only structure every operation maintains. Each
+ * index over it (the size classes or hole tree, the buddy and TLSF lists,
+ * the address index and the occupancy tree) is built from the list the
+ * first time an operation needs it, as its active flag records, and kept
+ * up to date from then on; until then the hooks skip it, so traces that
+ * never use it pay nothing. The size classes or hole tree are built on the
+ * first F, B or W search, the buddy lists on the first Y request, the
+ * TLSF lists on the first T request, the address index on the first range
+ * listing and the occupancy tree on the first STAT -v.
  */
-typedef struct Allocator {
+struct Allocator {
     size_t total_size;               ///< Total memory size
-    MemoryBlock *blocks;              ///< Linked list of memory blocks
+    BlockId blocks;                  ///< Head of the linked list of memory blocks
     int process_count;               ///< Number of allocated processes
-} Allocator;
+    BlockId free_lists[SIZE_CLASS_COUNT]; ///< Root of the (size, start) tree of each size class
+    uint64_t free_list_map;          ///< Bit k set when free_lists[k] is non-empty
+    BlockId hole_tree;               ///< Root of the (size, start) hole tree
+    BlockId address_tree;            ///< Root of the address index of allocated blocks
+    bool address_index_active;       ///< Whether the address index is being maintained
+    HoleIndexMode index_mode;        ///< Which hole index the strategies consult
+    bool hole_index_active;          ///< Whether the size classes or hole tree are being maintained
+    bool compact_on_fail;            ///< Compact a window and retry when any RQ fails
+    NameTable names;                 ///< Interned process names
+    BuddyIndex buddy;                ///< Free chunks for the buddy strategy
+    TlsfIndex tlsf;                  ///< Free lists for the TLSF strategy
+    OccupancyTree occupancy;         ///< Free bytes per address range for the memory map
+    size_t internal_waste;           ///< Bytes allocated beyond what processes requested
+    size_t rounding_waste;           ///< Of those, bytes added by rounding up to a size class
+    size_t align_reserve;            ///< Sum of align_reserve() over allocated blocks
+    size_t size_classes[ALLOCATOR_MAX_SIZE_CLASSES]; ///< Sizes requests are rounded up to, increasing
+    size_t size_class_count;         ///< Number of size classes (0 = no rounding)
+    size_t request_count;            ///< Requests that reached a strategy
+    size_t failed_request_count;     ///< Of those, requests no hole could satisfy
+    BlockId rover;                   ///< Where the next Next Fit search starts (NIL_BLOCK = list head)
+    size_t probes;                   ///< Blocks or index entries examined by the current search
+    size_t searches[ALLOCATOR_STRATEGY_COUNT]; ///< Hole searches made with each strategy
+    size_t search_probes[ALLOCATOR_STRATEGY_COUNT]; ///< Probes those searches made in total
+    size_t resize_in_place_count;    ///< Resizes done without moving the block
+    size_t resize_relocated_count;   ///< Resizes that moved the block to a new hole
+    size_t failed_resize_count;      ///< Resizes that found no room, leaving the block as it was
+    size_t resize_bytes_copied;      ///< Bytes the relocating resizes copied
+    size_t total_free;               ///< Bytes in holes, kept by the hole index hooks
+    size_t hole_count;               ///< Number of holes, kept by the hole index hooks
+    size_t largest_hole;             ///< At least the size of every hole; exact while largest_hole_valid
+    bool largest_hole_valid;         ///< Cleared when the largest hole shrinks or is removed
+    BlockPool pool;                  ///< Storage for all MemoryBlock nodes
+    void *snapshot;                  ///< Mapping of the snapshot last loaded, or NULL
+    size_t snapshot_length;          ///< Length of that mapping
+};
 
-/* ============================================================================
- * GLOBAL VARIABLES
- * ============================================================================ */
-
-static Allocator g_allocator;        ///< Global allocator instance
+/**
+ * @struct SnapshotHeader
+ * @brief Start of a snapshot file
+ * 
+ * The header is followed by the arrays, each at the offset recorded here.
+ * Nodes refer to each other and to names by id, never by pointer, so the
+ * arrays are valid wherever the file is mapped; only the pointers of the
+ * copied Allocator are cleared on saving and set again on loading. The
+ * layout is that of the build that wrote it, which the sizes check.
+ */
+typedef struct SnapshotHeader {
+    char magic[8];                   ///< SNAPSHOT_MAGIC
+    uint32_t version;                ///< SNAPSHOT_VERSION
+    uint32_t header_size;            ///< sizeof(SnapshotHeader) of the writer
+    uint64_t block_size;             ///< sizeof(MemoryBlock) of the writer
+    uint64_t length;                 ///< Length of the whole file
+    uint64_t checksum;               ///< snapshot_hash() of the whole file, taken with this field zero
+    uint64_t offsets[SNAPSHOT_SECTION_COUNT]; ///< File offset of each array
+    Allocator state;                 ///< The allocator, its pointers cleared
+} SnapshotHeader;
 
 /* ============================================================================
  * FUNCTION DECLARATIONS
  * ============================================================================ */
 
-// Initialization and cleanup
-static void allocator_init(Allocator *alloc, size_t total_size);
-static void allocator_cleanup(Allocator *alloc);
+// Initialization
+static void release_storage(Allocator *alloc);
+static void *clone_array(const void *array, size_t bytes, bool *ok);
+
+// Snapshots
+static void snapshot_sizes(const Allocator *alloc, size_t sizes[SNAPSHOT_SECTION_COUNT]);
+static uint64_t snapshot_hash(uint64_t hash, const void *array, size_t bytes);
+static bool snapshot_write_array(FILE *file, const void *array, size_t bytes);
+static void *snapshot_array(uint8_t *base, const SnapshotHeader *header, const size_t sizes[SNAPSHOT_SECTION_COUNT],
+                            SnapshotSection section);
 
 // Memory block management
-static MemoryBlock *create_block(size_t start, size_t end, MemoryBlockType type, const char *process_name);
-static void free_block(MemoryBlock *block);
-static void insert_block(Allocator *alloc, MemoryBlock *new_block);
-static void merge_adjacent_holes(Allocator *alloc);
+static MemoryBlock *block_pool_alloc(BlockPool *pool);
+static void block_pool_free(BlockPool *pool, MemoryBlock *block);
+static void block_pool_destroy(BlockPool *pool);
+static MemoryBlock *create_block(Allocator *alloc, size_t start, size_t end, MemoryBlockType type, NameId name);
+static void free_block(Allocator *alloc, MemoryBlock *block);
+static void link_block_before(Allocator *alloc, MemoryBlock *block, MemoryBlock *new_block);
+static void link_block_after(Allocator *alloc, MemoryBlock *block, MemoryBlock *new_block);
+static void unlink_block(Allocator *alloc, MemoryBlock *block);
+static MemoryBlock *merge_adjacent_holes(Allocator *alloc, MemoryBlock *hole);
+
+// Free-hole index
+static int size_class(size_t size);
+static void hole_index_file(Allocator *alloc, MemoryBlock *hole);
+static void hole_index_insert(Allocator *alloc, MemoryBlock *hole);
+static void hole_index_remove(Allocator *alloc, MemoryBlock *hole);
+static void hole_index_resize(Allocator *alloc, MemoryBlock *hole, size_t old_start, size_t old_size);
+static void hole_index_reset(Allocator *alloc);
+static void hole_index_build(Allocator *alloc);
+static MemoryBlock *find_first_fit_hole(Allocator *alloc, size_t size, size_t align);
+static MemoryBlock *find_best_fit_hole(Allocator *alloc, size_t size, size_t align);
+static MemoryBlock *find_worst_fit_hole(Allocator *alloc, size_t size, size_t align);
+static size_t largest_hole_size(Allocator *alloc);
+static BlockId hole_tree_insert(Allocator *alloc, BlockId id, MemoryBlock *hole);
+static BlockId hole_tree_remove(Allocator *alloc, BlockId id, MemoryBlock *hole, size_t size, size_t start);
+static MemoryBlock *hole_tree_lowest(Allocator *alloc, MemoryBlock *subtree);
+static MemoryBlock *hole_tree_first_fit(Allocator *alloc, BlockId id, size_t size, size_t align);
+static MemoryBlock *hole_tree_best_fit(Allocator *alloc, BlockId id, size_t size, size_t align);
+static MemoryBlock *hole_tree_worst_fit(Allocator *alloc, BlockId id, size_t size, size_t align);
+static size_t hole_tree_largest_aligned(Allocator *alloc, BlockId id, size_t align, size_t best);
+static size_t largest_aligned_block(Allocator *alloc, size_t align);
+
+// Address index
+static BlockId address_index_insert(Allocator *alloc, BlockId id, MemoryBlock *block);
+static BlockId address_index_remove(Allocator *alloc, BlockId id, MemoryBlock *block);
+static void address_index_add(Allocator *alloc, MemoryBlock *block);
+static void address_index_drop(Allocator *alloc, MemoryBlock *block);
+static MemoryBlock *address_index_find(Allocator *alloc, size_t address);
+
+// Buddy system
+static int buddy_order(size_t size);
+static void buddy_add_chunks(Allocator *alloc, MemoryBlock *hole);
+static void buddy_drop_chunks(Allocator *alloc, MemoryBlock *hole);
+static bool buddy_index_build(Allocator *alloc);
+static void buddy_index_clear(BuddyIndex *buddy);
+static bool buddy_index_unmap(BuddyIndex *buddy);
+static void buddy_index_destroy(BuddyIndex *buddy);
+
+// Two-level segregated fit
+static void tlsf_mapping(size_t size, int *fl, int *sl);
+static void tlsf_insert(Allocator *alloc, MemoryBlock *hole);
+static void tlsf_remove(Allocator *alloc, MemoryBlock *hole, size_t size);
+static MemoryBlock *tlsf_find(Allocator *alloc, size_t size);
+static MemoryBlock *tlsf_largest(Allocator *alloc);
+static bool tlsf_index_build(Allocator *alloc);
+static void tlsf_index_clear(TlsfIndex *tlsf);
+static bool tlsf_index_unmap(TlsfIndex *tlsf);
+static void tlsf_index_destroy(TlsfIndex *tlsf);
+
+// Occupancy tree
+static void occupancy_update(Allocator *alloc, size_t node, size_t lo, size_t hi,
+                             size_t start, size_t end, int delta);
+static void occupancy_mark(Allocator *alloc, size_t start, size_t end, int delta);
+static int64_t occupancy_free_bytes(const Allocator *alloc, size_t node, size_t lo, size_t hi,
+                                    size_t start, size_t end, int64_t covering);
+static bool occupancy_build(Allocator *alloc);
+static void occupancy_destroy(OccupancyTree *tree);
+
+// Process name table
+static bool name_table_init(NameTable *names);
+static NameId name_table_lookup(const NameTable *names, const char *name);
+static NameId name_table_intern(NameTable *names, const char *name);
+static bool name_table_unmap(NameTable *names);
+static void name_table_destroy(NameTable *names);
 
 // Allocation strategies
-static MemoryBlock *allocate_first_fit(Allocator *alloc, size_t size, const char *process_name);
-static MemoryBlock *allocate_best_fit(Allocator *alloc, size_t size, const char *process_name);
-static MemoryBlock *allocate_worst_fit(Allocator *alloc, size_t size, const char *process_name);
-static MemoryBlock *allocate_memory(Allocator *alloc, size_t size, const char *process_name, AllocationStrategy strategy);
+static MemoryBlock *allocate_first_fit(Allocator *alloc, size_t size, size_t align, NameId name);
+static MemoryBlock *allocate_best_fit(Allocator *alloc, size_t size, size_t align, NameId name);
+static MemoryBlock *allocate_worst_fit(Allocator *alloc, size_t size, size_t align, NameId name);
+static MemoryBlock *allocate_buddy(Allocator *alloc, size_t size, size_t align, NameId name);
+static MemoryBlock *allocate_tlsf(Allocator *alloc, size_t size, size_t align, NameId name);
+static MemoryBlock *allocate_next_fit(Allocator *alloc, size_t size, size_t align, NameId name);
+static MemoryBlock *carve_from_hole(Allocator *alloc, MemoryBlock *hole, size_t start, size_t size, NameId name);
+static size_t round_to_size_class(const Allocator *alloc, size_t size);
+static size_t size_class_floor(const Allocator *alloc, size_t size);
+static size_t largest_request(Allocator *alloc, size_t align, AllocationStrategy strategy);
+static MemoryBlock *allocate_memory(Allocator *alloc, size_t size, size_t align, NameId name,
+                                    AllocationStrategy strategy);
 
 // Memory operations
-static int release_memory(Allocator *alloc, const char *process_name);
-static void compact_memory(Allocator *alloc);
+static int release_memory(Allocator *alloc, NameId name);
+static MemoryBlock *resize_memory(Allocator *alloc, NameId name, size_t new_size, AllocationStrategy strategy,
+                                  bool *relocated);
+static size_t slide_blocks(Allocator *alloc, MemoryBlock *from, MemoryBlock *stop, size_t max_bytes_moved);
+static size_t compact_memory(Allocator *alloc, size_t max_bytes_moved);
+static size_t compaction_target(size_t size, size_t align, AllocationStrategy strategy);
+static bool find_compaction_window(Allocator *alloc, size_t needed, MemoryBlock **first, MemoryBlock **last,
+                                   size_t *cost);
+static bool compact_for_request(Allocator *alloc, size_t size, size_t align, AllocationStrategy strategy,
+                                size_t *moved);
 
 // Statistics and reporting
-static void print_statistics(Allocator *alloc, bool visualize);
-static void print_visualization(Allocator *alloc);
+static void print_block_listing(Allocator *alloc, FILE *out, size_t from, size_t to);
+static void print_tlsf_bitmaps(const Allocator *alloc, FILE *out);
+static void print_probe_lengths(const Allocator *alloc, FILE *out);
+static void print_visualization(Allocator *alloc, FILE *out, size_t width, size_t from, size_t to);
 static void calculate_fragmentation(Allocator *alloc, size_t *total_allocated, size_t *total_free, 
-                                    size_t *largest_hole, double *external_frag, double *avg_hole_size);
-
-// Command parsing and execution
-static void process_command(Allocator *alloc, const char *command);
-static void execute_simulation(Allocator *alloc, const char *filename);
-static AllocationStrategy parse_strategy(char strategy_char);
+                                    size_t *largest_hole, size_t *hole_count,
+                                    double *external_frag, double *avg_hole_size,
+                                    double *internal_frag, double *rounding_frag);
 
 // Utility functions
-static size_t parse_size(const char *str);
-static void trim_whitespace(char *str);
 static bool is_valid_process_name(const char *name);
+static int size_unit(size_t bytes);
+static const char *format_size_in(size_t bytes, int unit, char text[SIZE_TEXT_LENGTH]);
+static const char *format_size(size_t bytes, char text[SIZE_TEXT_LENGTH]);
 
 /* ============================================================================
- * MAIN FUNCTION
+ * NODE ACCESSORS
  * ============================================================================ */
 
 /**
- * @brief Main entry point of the program
+ * @brief Resolve a pool id to its node
  * 
- * Initializes the allocator with the specified memory size and enters
- * the interactive command loop.
- * 
- * @param argc Number of command-line arguments
- * @param argv Array of command-line argument strings
- * @return EXIT_SUCCESS on success, EXIT_FAILURE on error
+ * @param alloc Pointer to Allocator structure
+ * @param id Block id (NIL_BLOCK allowed)
+ * @return The node, or NULL for NIL_BLOCK
  */
-int main(int argc, char *argv[]) {
-    // Check for correct number of arguments
-    if (argc != 2) {
-        fprintf(stderr, "Usage: %s <memory_size>\n", argv[0]);
-        fprintf(stderr, "Example: %s 1048576\n", argv[0]);
-        return EXIT_FAILURE;
-    }
-    
-    // Parse memory size
-    size_t memory_size = parse_size(argv[1]);
-    if (memory_size == 0) {
-        fprintf(stderr, "Error: Invalid memory size '%s'\n", argv[1]);
-        return EXIT_FAILURE;
-    }
-    
-    // Initialize allocator
-    allocator_init(&g_allocator, memory_size);
-    
-    // Interactive command loop
-    char line[MAX_LINE_LENGTH];
-    printf("allocator>");
-    fflush(stdout);
-    
-    while (fgets(line, sizeof(line), stdin) != NULL) {
-        // Remove trailing newline
-        size_t len = strlen(line);
-        if (len > 0 && line[len - 1] == '\n') {
-            line[len - 1] = '\0';
-        }
-        
-        // Skip empty lines
-        if (strlen(line) == 0) {
-            printf("allocator>");
-            fflush(stdout);
-            continue;
-        }
-        
-        // Process command
-        process_command(&g_allocator, line);
-        
-        // Check if we should exit
-        if (strcmp(line, "X") == 0) {
-            break;
-        }
-        
-        printf("allocator>");
-        fflush(stdout);
+static inline MemoryBlock *block_at(const Allocator *alloc, BlockId id) {
+    if (id == NIL_BLOCK) {
+        return NULL;
     }
-    
-    // Cleanup
-    allocator_cleanup(&g_allocator);
-    
-    return EXIT_SUCCESS;
+    return &alloc->pool.slabs[(id - 1) / BLOCK_POOL_SLAB_SIZE][(id - 1) % BLOCK_POOL_SLAB_SIZE];
+}
+
+/**
+ * @brief Id of a node, or NIL_BLOCK for NULL
+ */
+static inline BlockId block_id(const MemoryBlock *block) {
+    return (block != NULL) ? block->id : NIL_BLOCK;
+}
+
+/**
+ * @brief Size of a block (derived, not stored)
+ */
+static inline size_t block_size(const MemoryBlock *block) {
+    return block->end - block->start;
+}
+
+/**
+ * @brief First block in address order
+ */
+static inline MemoryBlock *first_block(const Allocator *alloc) {
+    return block_at(alloc, alloc->blocks);
+}
+
+/**
+ * @brief Following block in address order, or NULL at the end
+ */
+static inline MemoryBlock *next_block(const Allocator *alloc, const MemoryBlock *block) {
+    return block_at(alloc, block->next);
+}
+
+/**
+ * @brief Preceding block in address order, or NULL at the start
+ */
+static inline MemoryBlock *prev_block(const Allocator *alloc, const MemoryBlock *block) {
+    return block_at(alloc, block->prev);
+}
+
+/**
+ * @brief Bytes to skip from start to reach a multiple of align (a power of two)
+ */
+static inline size_t align_padding(size_t start, size_t align) {
+    return (align - (start & (align - 1))) & (align - 1);
+}
+
+/**
+ * @brief Whether a block of size bytes, aligned to align, fits in a hole
+ */
+static inline bool hole_fits(const MemoryBlock *hole, size_t size, size_t align) {
+    return block_size(hole) >= size && block_size(hole) - size >= align_padding(hole->start, align);
+}
+
+/**
+ * @brief Smallest hole size that fits an aligned block wherever the hole starts
+ */
+static inline size_t padded_size(size_t size, size_t align) {
+    return (size <= SIZE_MAX - (align - 1)) ? size + (align - 1) : SIZE_MAX;
+}
+
+/**
+ * @brief Most alignment padding compaction can leave in front of an allocated block
+ * 
+ * A block slides down only to the next multiple of its alignment, so up
+ * to align - 1 of the bytes gathered in front of it stay behind as a hole.
+ * An alignment past the memory size only fits the block at address 0,
+ * which never slides, so the reserve is capped at the memory size.
+ */
+static inline size_t align_reserve(const Allocator *alloc, const MemoryBlock *block) {
+    size_t reserve = ((size_t)1 << block->align_log2) - 1;
+    return (reserve < alloc->total_size) ? reserve : alloc->total_size;
+}
+
+/**
+ * @brief String of an interned name ("" for NO_NAME)
+ */
+static inline const char *name_string(const Allocator *alloc, NameId name) {
+    return alloc->names.chars + alloc->names.offsets[name];
 }
 
+/**
+ * @brief Process name of a block ("" for a hole)
+ */
+static inline const char *block_name(const Allocator *alloc, const MemoryBlock *block) {
+    return name_string(alloc, block->name);
+}
 /* ============================================================================
  * INITIALIZATION AND CLEANUP
  * ============================================================================ */
 
 /**
- * @brief Initialize the allocator with a single free block
+ * @brief Create an allocator whose memory is a single free block
  * 
- * @param alloc Pointer to Allocator structure
  * @param total_size Total memory size to manage
+ * @param index_mode Hole index the allocation strategies should use
+ * @return New allocator, or NULL on error
  */
-static void allocator_init(Allocator *alloc, size_t total_size) {
-    memset(alloc, 0, sizeof(Allocator));
+Allocator *allocator_create(size_t total_size, HoleIndexMode index_mode) {
+    if (total_size == 0) {
+        return NULL;
+    }
+    Allocator *alloc = (Allocator *)calloc(1, sizeof(Allocator));
+    if (alloc == NULL) {
+        return NULL;
+    }
     alloc->total_size = total_size;
-    alloc->blocks = NULL;
+    alloc->index_mode = index_mode;
+    alloc->blocks = NIL_BLOCK;
     alloc->process_count = 0;
+    alloc->largest_hole_valid = true;
     
     // Create initial free block covering entire memory
-    MemoryBlock *initial_block = create_block(0, total_size, BLOCK_FREE, "");
+    MemoryBlock *initial_block = NULL;
+    if (name_table_init(&alloc->names)) {
+        initial_block = create_block(alloc, 0, total_size, BLOCK_FREE, NO_NAME);
+    }
     if (initial_block == NULL) {
-        fprintf(stderr, "Error: Failed to initialize allocator\n");
-        exit(EXIT_FAILURE);
+        allocator_destroy(alloc);
+        return NULL;
     }
-    alloc->blocks = initial_block;
+    alloc->blocks = initial_block->id;
+    hole_index_insert(alloc, initial_block);
+    return alloc;
 }
 
 /**
- * @brief Cleanup allocator and free all memory blocks
+ * @brief Free everything an allocator holds, leaving the structure itself
+ * 
+ * Every node lives in the block pool, so the list is released in bulk by
+ * dropping the pool's slabs rather than node by node. Arrays that live in
+ * a loaded snapshot go with its mapping.
  * 
  * @param alloc Pointer to Allocator structure
  */
-static void allocator_cleanup(Allocator *alloc) {
-    MemoryBlock *current = alloc->blocks;
-    while (current != NULL) {
-        MemoryBlock *next = current->next;
-        free_block(current);
-        current = next;
+static void release_storage(Allocator *alloc) {
+    block_pool_destroy(&alloc->pool);
+    alloc->blocks = NIL_BLOCK;
+    alloc->rover = NIL_BLOCK;
+    alloc->address_tree = NIL_BLOCK;
+    alloc->address_index_active = false;
+    hole_index_reset(alloc);
+    buddy_index_destroy(&alloc->buddy);
+    tlsf_index_destroy(&alloc->tlsf);
+    occupancy_destroy(&alloc->occupancy);
+    name_table_destroy(&alloc->names);
+    if (alloc->snapshot != NULL) {
+        munmap(alloc->snapshot, alloc->snapshot_length);
+        alloc->snapshot = NULL;
+        alloc->snapshot_length = 0;
+    }
+}
+
+/**
+ * @brief Free an allocator and all its memory blocks
+ * 
+ * @param alloc Pointer to Allocator structure (NULL is ignored)
+ */
+void allocator_destroy(Allocator *alloc) {
+    if (alloc == NULL) {
+        return;
+    }
+    release_storage(alloc);
+    free(alloc);
+}
+
+/**
+ * @brief Copy an array into a new allocation
+ * 
+ * @param array Array to copy (NULL gives NULL)
+ * @param bytes Size of the array
+ * @param ok Cleared if memory ran out
+ * @return The copy, or NULL
+ */
+static void *clone_array(const void *array, size_t bytes, bool *ok) {
+    if (array == NULL || bytes == 0) {
+        return NULL;
+    }
+    void *copy = malloc(bytes);
+    if (copy == NULL) {
+        *ok = false;
+        return NULL;
+    }
+    memcpy(copy, array, bytes);
+    return copy;
+}
+
+/**
+ * @brief Make an independent copy of an allocator's whole state
+ * 
+ * Blocks link by pool id and names by table id, never by pointer, so
+ * every array can be copied verbatim: the copy's ids resolve to its own
+ * nodes, and name ids interned before the copy mean the same in both.
+ * 
+ * @param alloc Allocator to copy
+ * @return The copy, or NULL if memory ran out
+ */
+Allocator *allocator_clone(const Allocator *alloc) {
+    Allocator *copy = (Allocator *)malloc(sizeof(Allocator));
+    if (copy == NULL) {
+        return NULL;
+    }
+    *copy = *alloc;
+    
+    // Detach every array first so a partial copy can be destroyed safely
+    memset(&copy->pool, 0, sizeof(BlockPool));
+    copy->snapshot = NULL;
+    copy->snapshot_length = 0;
+    copy->buddy.chunks = NULL;
+    copy->buddy.mapped = false;
+    copy->tlsf.next = NULL;
+    copy->tlsf.prev = NULL;
+    copy->tlsf.mapped = false;
+    memset(&copy->occupancy, 0, sizeof(OccupancyTree)); // Rebuilt on the copy's first STAT -v
+    copy->names.mapped = false;
+    copy->names.chars = NULL;
+    copy->names.offsets = NULL;
+    copy->names.owners = NULL;
+    copy->names.requested = NULL;
+    copy->names.slots = NULL;
+    
+    bool ok = true;
+    const NameTable *names = &alloc->names;
+    copy->names.chars = (char *)clone_array(names->chars, names->chars_capacity, &ok);
+    copy->names.offsets = (size_t *)clone_array(names->offsets, names->id_capacity * sizeof(size_t), &ok);
+    copy->names.owners = (BlockId *)clone_array(names->owners, names->id_capacity * sizeof(BlockId), &ok);
+    copy->names.requested = (size_t *)clone_array(names->requested, names->id_capacity * sizeof(size_t), &ok);
+    copy->names.slots = (NameId *)clone_array(names->slots, names->slot_capacity * sizeof(NameId), &ok);
+    copy->buddy.chunks = (BuddyChunk *)clone_array(alloc->buddy.chunks,
+                                                   alloc->buddy.chunk_capacity * sizeof(BuddyChunk), &ok);
+    copy->tlsf.next = (BlockId *)clone_array(alloc->tlsf.next, alloc->tlsf.link_capacity * sizeof(BlockId), &ok);
+    copy->tlsf.prev = (BlockId *)clone_array(alloc->tlsf.prev, alloc->tlsf.link_capacity * sizeof(BlockId), &ok);
+    
+    MemoryBlock **slabs = (MemoryBlock **)calloc(alloc->pool.slab_capacity, sizeof(MemoryBlock *));
+    copy->pool.slabs = slabs;
+    ok = ok && slabs != NULL;
+    for (size_t i = 0; ok && i < alloc->pool.slab_count; i++) {
+        slabs[i] = (MemoryBlock *)clone_array(alloc->pool.slabs[i], BLOCK_POOL_SLAB_SIZE * sizeof(MemoryBlock), &ok);
+        copy->pool.slab_count += ok;
+    }
+    if (!ok) {
+        allocator_destroy(copy);
+        return NULL;
+    }
+    copy->pool = alloc->pool;
+    copy->pool.slabs = slabs;
+    copy->pool.mapped_slabs = 0;
+    return copy;
+}
+
+/**
+ * @brief Make every request compact a window and retry when no hole fits
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param enabled Whether failed requests should compact
+ */
+void allocator_set_compact_on_fail(Allocator *alloc, bool enabled) {
+    alloc->compact_on_fail = enabled;
+}
+
+/**
+ * @brief Round every request up to one of a set of size classes
+ * 
+ * The classes cannot change while blocks are held, since a release works
+ * out the rounding it undoes from the size requested.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param classes Class sizes in increasing order
+ * @param count Number of classes (0 turns rounding off)
+ * @return true on success, false if memory is in use or the classes are invalid
+ */
+bool allocator_set_size_classes(Allocator *alloc, const size_t *classes, size_t count) {
+    if (alloc->process_count > 0 || count > ALLOCATOR_MAX_SIZE_CLASSES) {
+        return false;
     }
-    alloc->blocks = NULL;
+    for (size_t i = 0; i < count; i++) {
+        if (classes[i] == 0 || (i > 0 && classes[i] <= classes[i - 1])) {
+            return false;
+        }
+    }
+    
+    if (count > 0) {
+        memcpy(alloc->size_classes, classes, count * sizeof(size_t));
+    }
+    alloc->size_class_count = count;
+    return true;
 }
 
 /* ============================================================================
  * MEMORY BLOCK MANAGEMENT
  * ============================================================================ */
 
+/**
+ * @brief Take a node from the pool, carving a new slab if none is free
+ * 
+ * @param pool Pointer to BlockPool structure
+ * @return Node with its id set, or NULL if a new slab could not be allocated
+ */
+static MemoryBlock *block_pool_alloc(BlockPool *pool) {
+    MemoryBlock *block;
+    
+    if (pool->free_nodes != NIL_BLOCK) {
+        BlockId id = pool->free_nodes;
+        block = &pool->slabs[(id - 1) / BLOCK_POOL_SLAB_SIZE][(id - 1) % BLOCK_POOL_SLAB_SIZE];
+        pool->free_nodes = block->next;
+    } else {
+        if (pool->slab_count == 0 || pool->slab_used == BLOCK_POOL_SLAB_SIZE) {
+            if (pool->slab_count == pool->slab_capacity) {
+                size_t new_capacity = (pool->slab_capacity == 0) ? 8 : pool->slab_capacity * 2;
+                MemoryBlock **new_slabs = (MemoryBlock **)realloc(pool->slabs, new_capacity * sizeof(MemoryBlock *));
+                if (new_slabs == NULL) {
+                    return NULL;
+                }
+                pool->slabs = new_slabs;
+                pool->slab_capacity = new_capacity;
+            }
+            
+            MemoryBlock *slab = (MemoryBlock *)malloc(BLOCK_POOL_SLAB_SIZE * sizeof(MemoryBlock));
+            if (slab == NULL) {
+                return NULL;
+            }
+            pool->slabs[pool->slab_count++] = slab;
+            pool->slab_used = 0;
+        }
+        block = &pool->slabs[pool->slab_count - 1][pool->slab_used];
+        block->id = (BlockId)((pool->slab_count - 1) * BLOCK_POOL_SLAB_SIZE + pool->slab_used + 1);
+        pool->slab_used++;
+    }
+    
+    pool->live_nodes++;
+    if (pool->live_nodes > pool->high_water) {
+        pool->high_water = pool->live_nodes;
+    }
+    return block;
+}
+
+/**
+ * @brief Return a node to the pool's free list
+ * 
+ * @param pool Pointer to BlockPool structure
+ * @param block Node to recycle
+ */
+static void block_pool_free(BlockPool *pool, MemoryBlock *block) {
+    block->next = pool->free_nodes;
+    pool->free_nodes = block->id;
+    pool->live_nodes--;
+}
+
+/**
+ * @brief Release every slab at once
+ * 
+ * @param pool Pointer to BlockPool structure
+ */
+static void block_pool_destroy(BlockPool *pool) {
+    for (size_t i = pool->mapped_slabs; i < pool->slab_count; i++) {
+        free(pool->slabs[i]);
+    }
+    free(pool->slabs);
+    memset(pool, 0, sizeof(BlockPool));
+}
+
 /**
  * @brief Create a new memory block
  * 
+ * @param alloc Pointer to Allocator structure (owner of the block pool)
  * @param start Starting address
  * @param end Ending address (exclusive)
  * @param type Block type (allocated or free)
- * @param process_name Process name (empty string for free blocks)
+ * @param name Interned process name (NO_NAME for free blocks)
  * @return Pointer to new MemoryBlock, or NULL on error
  */
-static MemoryBlock *create_block(size_t start, size_t end, MemoryBlockType type, const char *process_name) {
-    MemoryBlock *block = (MemoryBlock *)malloc(sizeof(MemoryBlock));
+static MemoryBlock *create_block(Allocator *alloc, size_t start, size_t end, MemoryBlockType type, NameId name) {
+    MemoryBlock *block = block_pool_alloc(&alloc->pool);
     if (block == NULL) {
         return NULL;
     }
     
     block->start = start;
     block->end = end;
-    block->size = end - start;
-    block->type = type;
-    block->next = NULL;
-    
-    if (process_name != NULL) {
-        strncpy(block->process_name, process_name, MAX_PROCESS_NAME_LENGTH - 1);
-        block->process_name[MAX_PROCESS_NAME_LENGTH - 1] = '\0';
-    } else {
-        block->process_name[0] = '\0';
-    }
+    block->type = (uint8_t)type;
+    block->name = name;
+    block->next = NIL_BLOCK;
+    block->prev = NIL_BLOCK;
+    block->tree_left = NIL_BLOCK;
+    block->tree_right = NIL_BLOCK;
+    block->buddy_chunks = 0;
+    block->tree_min_start = start;
+    block->tree_height = 1;
+    block->align_log2 = 0;
     
     return block;
 }
@@ -278,813 +850,3675 @@ static MemoryBlock *create_block(size_t start, size_t end, MemoryBlockType type,
 /**
  * @brief Free a memory block
  * 
+ * @param alloc Pointer to Allocator structure (owner of the block pool)
  * @param block Pointer to MemoryBlock to free
  */
-static void free_block(MemoryBlock *block) {
+static void free_block(Allocator *alloc, MemoryBlock *block) {
     if (block != NULL) {
-        free(block);
+        block_pool_free(&alloc->pool, block);
     }
 }
 
 /**
- * @brief Insert a block into the sorted linked list
+ * @brief Link a block into the list immediately before another block
  * 
- * Blocks are maintained in sorted order by starting address.
+ * @param alloc Pointer to Allocator structure
+ * @param block Block already in the list
+ * @param new_block Block to link in front of it
+ */
+static void link_block_before(Allocator *alloc, MemoryBlock *block, MemoryBlock *new_block) {
+    MemoryBlock *prev = prev_block(alloc, block);
+    new_block->prev = block->prev;
+    new_block->next = block->id;
+    if (prev != NULL) {
+        prev->next = new_block->id;
+    } else {
+        alloc->blocks = new_block->id;
+    }
+    block->prev = new_block->id;
+}
+
+/**
+ * @brief Link a block into the list immediately after another block
  * 
  * @param alloc Pointer to Allocator structure
- * @param new_block Block to insert
+ * @param block Block already in the list
+ * @param new_block Block to link behind it
  */
-static void insert_block(Allocator *alloc, MemoryBlock *new_block) {
-    if (alloc->blocks == NULL) {
-        alloc->blocks = new_block;
-        new_block->next = NULL;
-        return;
+static void link_block_after(Allocator *alloc, MemoryBlock *block, MemoryBlock *new_block) {
+    MemoryBlock *next = next_block(alloc, block);
+    new_block->prev = block->id;
+    new_block->next = block->next;
+    if (next != NULL) {
+        next->prev = new_block->id;
     }
-    
-    // Insert at head if before first block
-    if (new_block->start < alloc->blocks->start) {
-        new_block->next = alloc->blocks;
-        alloc->blocks = new_block;
-        return;
+    block->next = new_block->id;
+}
+
+/**
+ * @brief Unlink a block from the list (the caller frees it)
+ * 
+ * If the Next Fit rover points at the block, it steps back to the previous
+ * one. When holes merge, that is the hole that absorbed this one.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param block Block to unlink
+ */
+static void unlink_block(Allocator *alloc, MemoryBlock *block) {
+    MemoryBlock *prev = prev_block(alloc, block);
+    MemoryBlock *next = next_block(alloc, block);
+    if (prev != NULL) {
+        prev->next = block->next;
+    } else {
+        alloc->blocks = block->next;
     }
-    
-    // Find insertion point
-    MemoryBlock *current = alloc->blocks;
-    while (current->next != NULL && current->next->start < new_block->start) {
-        current = current->next;
+    if (next != NULL) {
+        next->prev = block->prev;
     }
-    
-    new_block->next = current->next;
-    current->next = new_block;
+    if (alloc->rover == block->id) {
+        alloc->rover = block->prev;
+    }
+    block->prev = NIL_BLOCK;
+    block->next = NIL_BLOCK;
 }
 
-
 /**
- * @brief Merge adjacent free blocks (holes)
+ * @brief Merge a newly freed block with its free neighbours
  * 
- * After a release operation, adjacent free blocks should be merged
- * into a single larger free block.
+ * Holes are never left adjacent to each other, so only the immediate
+ * neighbours of the freed block can need merging. The surviving hole is
+ * filed in the hole index; the freed block must not be indexed yet.
  * 
  * @param alloc Pointer to Allocator structure
+ * @param hole Block that just became free
+ * @return The hole that now covers the freed range
  */
-static void merge_adjacent_holes(Allocator *alloc) {
-    MemoryBlock *current = alloc->blocks;
+static MemoryBlock *merge_adjacent_holes(Allocator *alloc, MemoryBlock *hole) {
+    // Absorb the following hole
+    MemoryBlock *next = next_block(alloc, hole);
+    if (next != NULL && next->type == BLOCK_FREE && hole->end == next->start) {
+        hole_index_remove(alloc, next);
+        hole->end = next->end;
+        unlink_block(alloc, next);
+        free_block(alloc, next);
+    }
     
-    while (current != NULL && current->next != NULL) {
-        // If current and next are both free and adjacent
-        if (current->type == BLOCK_FREE && 
-            current->next->type == BLOCK_FREE &&
-            current->end == current->next->start) {
-            
-            // Merge next into current
-            current->end = current->next->end;
-            current->size = current->end - current->start;
-            
-            // Remove next block
-            MemoryBlock *to_remove = current->next;
-            current->next = to_remove->next;
-            free_block(to_remove);
-            
-            // Don't advance - check if we can merge again
-        } else {
-            current = current->next;
-        }
+    // Fold into the preceding hole
+    MemoryBlock *prev = prev_block(alloc, hole);
+    if (prev != NULL && prev->type == BLOCK_FREE && prev->end == hole->start) {
+        size_t old_size = block_size(prev);
+        prev->end = hole->end;
+        unlink_block(alloc, hole);
+        free_block(alloc, hole);
+        hole_index_resize(alloc, prev, prev->start, old_size);
+        return prev;
     }
+    
+    hole_index_insert(alloc, hole);
+    return hole;
 }
 
 /* ============================================================================
- * ALLOCATION STRATEGIES
+ * SEGREGATED FREE LISTS
  * ============================================================================ */
 
 /**
- * @brief First Fit allocation strategy
+ * @brief Map a hole size to its segregated size class
  * 
- * Allocates from the first hole large enough to satisfy the request.
+ * Class k holds holes whose size lies in [2^k, 2^(k+1)). Zero-sized holes
+ * (left behind by an exact worst-fit split) share class 0.
  * 
- * @param alloc Pointer to Allocator structure
- * @param size Size to allocate
- * @param process_name Name of the process requesting memory
- * @return Pointer to allocated block, or NULL if allocation fails
+ * @param size Hole size in bytes
+ * @return Size class index in [0, SIZE_CLASS_COUNT)
  */
-static MemoryBlock *allocate_first_fit(Allocator *alloc, size_t size, const char *process_name) {
-    MemoryBlock *current = alloc->blocks;
-    
-    while (current != NULL) {
-        if (current->type == BLOCK_FREE && current->size >= size) {
-            // Found a suitable hole
-            size_t allocated_start = current->start;
-            size_t allocated_end = allocated_start + size;
-            
-            // Update current block (shrink it)
-            if (current->size == size) {
-                // Exact fit - convert entire block to allocated
-                current->type = BLOCK_ALLOCATED;
-                strncpy(current->process_name, process_name, MAX_PROCESS_NAME_LENGTH - 1);
-                current->process_name[MAX_PROCESS_NAME_LENGTH - 1] = '\0';
-                return current;
-            } else {
-                // Partial fit - split the block
-                current->start = allocated_end;
-                current->size = current->end - current->start;
-                
-                // Create new allocated block
-                MemoryBlock *allocated = create_block(allocated_start, allocated_end, 
-                                                      BLOCK_ALLOCATED, process_name);
-                if (allocated == NULL) {
-                    // Restore original block on failure
-                    current->start = allocated_start;
-                    current->size = current->end - current->start;
-                    return NULL;
-                }
-                
-                // Insert allocated block before current
-                if (alloc->blocks == current) {
-                    allocated->next = current;
-                    alloc->blocks = allocated;
-                } else {
-                    MemoryBlock *prev = alloc->blocks;
-                    while (prev->next != current) {
-                        prev = prev->next;
-                    }
-                    prev->next = allocated;
-                    allocated->next = current;
-                }
-                
-                return allocated;
-            }
-        }
-        current = current->next;
+static int size_class(size_t size) {
+    if (size < 2) {
+        return 0;
     }
-    
-    return NULL; // No suitable hole found
+    return 63 - __builtin_clzll((unsigned long long)size);
 }
 
 /**
- * @brief Best Fit allocation strategy
- * 
- * Allocates from the smallest hole large enough to satisfy the request.
+ * @brief Remove a hole from the tree of the class it was filed under
  * 
  * @param alloc Pointer to Allocator structure
- * @param size Size to allocate
- * @param process_name Name of the process requesting memory
- * @return Pointer to allocated block, or NULL if allocation fails
+ * @param hole Hole to remove
+ * @param size Size the hole was indexed under
+ * @param start Start address the hole was indexed under
  */
-static MemoryBlock *allocate_best_fit(Allocator *alloc, size_t size, const char *process_name) {
-    MemoryBlock *best = NULL;
-    size_t best_size = SIZE_MAX;
-    MemoryBlock *current = alloc->blocks;
+static void free_list_remove(Allocator *alloc, MemoryBlock *hole, size_t size, size_t start) {
+    int cls = size_class(size);
+    alloc->free_lists[cls] = hole_tree_remove(alloc, alloc->free_lists[cls], hole, size, start);
+    if (alloc->free_lists[cls] == NIL_BLOCK) {
+        alloc->free_list_map &= ~(1ULL << cls);
+    }
+}
+
+/**
+ * @brief Add a hole to the tree of its size class
+ * 
+ * Each class is a small (size, start) tree built from the hole tree's
+ * nodes and rotations, so filing a hole takes O(log k) for the k holes of
+ * its class, and the root's cached subtree minimum is the lowest-addressed
+ * hole of the class, which is what First Fit needs.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param hole Free block to index
+ */
+static void free_list_insert(Allocator *alloc, MemoryBlock *hole) {
+    int cls = size_class(block_size(hole));
+    alloc->free_lists[cls] = hole_tree_insert(alloc, alloc->free_lists[cls], hole);
+    alloc->free_list_map |= 1ULL << cls;
+}
+
+/**
+ * @brief Find the lowest-addressed hole that fits an aligned block
+ * 
+ * Every hole in a class whose smallest size covers the request plus the
+ * worst-case alignment padding fits, so each of those classes offers just
+ * the lowest address cached at its root, and only the winner is looked up.
+ * The classes below that (just the request's own class when there is no
+ * alignment) are searched with hole_tree_first_fit(), and only while their
+ * lowest address could still beat the best candidate so far; with
+ * alignment that search pays for every hole in the band it walks.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param size Requested size
+ * @param align Alignment of the block's start (a power of two)
+ * @return Matching hole, or NULL if none fits
+ */
+static MemoryBlock *free_list_first_fit(Allocator *alloc, size_t size, size_t align) {
+    size_t padded = padded_size(size, align);
+    MemoryBlock *first = NULL;
+    MemoryBlock *subtree = NULL;
+    size_t first_start = SIZE_MAX;
+    uint64_t candidates = alloc->free_list_map & (~0ULL << size_class(size));
+    
+    while (candidates != 0) {
+        int cls = __builtin_ctzll(candidates);
+        MemoryBlock *root = block_at(alloc, alloc->free_lists[cls]);
+        alloc->probes++;
+        if (root->tree_min_start < first_start) {
+            if (((size_t)1 << cls) >= padded) {
+                first = NULL;
+                subtree = root;
+                first_start = root->tree_min_start;
+            } else {
+                MemoryBlock *current = hole_tree_first_fit(alloc, root->id, size, align);
+                if (current != NULL && current->start < first_start) {
+                    first = current;
+                    subtree = NULL;
+                    first_start = current->start;
+                }
+            }
+        }
+        candidates &= candidates - 1;
+    }
+    
+    return (first != NULL) ? first : hole_tree_lowest(alloc, subtree);
+}
+
+/**
+ * @brief Find the smallest hole that fits an aligned block
+ * 
+ * Ties go to the lowest address, exactly like a front-to-back list scan.
+ * Any hole in the request's class that fits beats every hole in a larger
+ * class, so the classes are tried from the smallest up with a best-fit
+ * lookup in each tree; without alignment at most two are searched.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param size Requested size
+ * @param align Alignment of the block's start (a power of two)
+ * @return Matching hole, or NULL if none fits
+ */
+static MemoryBlock *free_list_best_fit(Allocator *alloc, size_t size, size_t align) {
+    uint64_t candidates = alloc->free_list_map & (~0ULL << size_class(size));
+    
+    while (candidates != 0) {
+        MemoryBlock *best = hole_tree_best_fit(alloc, alloc->free_lists[__builtin_ctzll(candidates)], size, align);
+        if (best != NULL) {
+            return best;
+        }
+        candidates &= candidates - 1;
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief Find the largest hole, provided it fits an aligned block
+ * 
+ * Only the highest non-empty class can hold the largest hole. Ties go to the
+ * lowest address, like a front-to-back list scan.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param size Requested size
+ * @param align Alignment of the block's start (a power of two)
+ * @return Matching hole, or NULL if the largest hole does not fit
+ */
+static MemoryBlock *free_list_worst_fit(Allocator *alloc, size_t size, size_t align) {
+    if (alloc->free_list_map == 0) {
+        return NULL;
+    }
+    return hole_tree_worst_fit(alloc, alloc->free_lists[63 - __builtin_clzll(alloc->free_list_map)], size, align);
+}
+
+/* ============================================================================
+ * BALANCED HOLE TREE
+ * ============================================================================ */
+
+/**
+ * @brief Height of an AVL subtree (0 for an empty subtree)
+ */
+static int hole_tree_height(const Allocator *alloc, BlockId id) {
+    return (id != NIL_BLOCK) ? block_at(alloc, id)->tree_height : 0;
+}
+
+/**
+ * @brief Recompute a node's height and lowest hole address from its children
+ * 
+ * Each node caches the smallest start address in its subtree, which lets
+ * First Fit answer "lowest address among holes of at least N bytes" without
+ * visiting every qualifying hole.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param node Tree node to refresh
+ */
+static void hole_tree_update(Allocator *alloc, MemoryBlock *node) {
+    MemoryBlock *left = block_at(alloc, node->tree_left);
+    MemoryBlock *right = block_at(alloc, node->tree_right);
+    int left_height = (left != NULL) ? left->tree_height : 0;
+    int right_height = (right != NULL) ? right->tree_height : 0;
+    node->tree_height = (uint8_t)(1 + (left_height > right_height ? left_height : right_height));
+    
+    node->tree_min_start = node->start;
+    if (left != NULL && left->tree_min_start < node->tree_min_start) {
+        node->tree_min_start = left->tree_min_start;
+    }
+    if (right != NULL && right->tree_min_start < node->tree_min_start) {
+        node->tree_min_start = right->tree_min_start;
+    }
+}
+
+static BlockId hole_tree_rotate_right(Allocator *alloc, BlockId id) {
+    MemoryBlock *node = block_at(alloc, id);
+    MemoryBlock *pivot = block_at(alloc, node->tree_left);
+    node->tree_left = pivot->tree_right;
+    pivot->tree_right = id;
+    hole_tree_update(alloc, node);
+    hole_tree_update(alloc, pivot);
+    return pivot->id;
+}
+
+static BlockId hole_tree_rotate_left(Allocator *alloc, BlockId id) {
+    MemoryBlock *node = block_at(alloc, id);
+    MemoryBlock *pivot = block_at(alloc, node->tree_right);
+    node->tree_right = pivot->tree_left;
+    pivot->tree_left = id;
+    hole_tree_update(alloc, node);
+    hole_tree_update(alloc, pivot);
+    return pivot->id;
+}
+
+/**
+ * @brief Restore the AVL balance invariant at a node
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param id Subtree root whose children were just modified
+ * @return New subtree root
+ */
+static BlockId hole_tree_rebalance(Allocator *alloc, BlockId id) {
+    MemoryBlock *node = block_at(alloc, id);
+    hole_tree_update(alloc, node);
+    int balance = hole_tree_height(alloc, node->tree_left) - hole_tree_height(alloc, node->tree_right);
+    
+    if (balance > 1) {
+        MemoryBlock *left = block_at(alloc, node->tree_left);
+        if (hole_tree_height(alloc, left->tree_left) < hole_tree_height(alloc, left->tree_right)) {
+            node->tree_left = hole_tree_rotate_left(alloc, node->tree_left);
+        }
+        return hole_tree_rotate_right(alloc, id);
+    }
+    if (balance < -1) {
+        MemoryBlock *right = block_at(alloc, node->tree_right);
+        if (hole_tree_height(alloc, right->tree_right) < hole_tree_height(alloc, right->tree_left)) {
+            node->tree_right = hole_tree_rotate_right(alloc, node->tree_right);
+        }
+        return hole_tree_rotate_left(alloc, id);
+    }
+    return id;
+}
+
+/**
+ * @brief Compare a (size, start) key against a node's key
+ * 
+ * @return Negative, zero or positive as the key sorts before, equal to or after the node
+ */
+static int hole_tree_compare(size_t size, size_t start, const MemoryBlock *node) {
+    size_t node_size = block_size(node);
+    if (size != node_size) {
+        return (size < node_size) ? -1 : 1;
+    }
+    if (start != node->start) {
+        return (start < node->start) ? -1 : 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Insert a hole into the subtree rooted at id
+ * 
+ * @return New subtree root
+ */
+static BlockId hole_tree_insert(Allocator *alloc, BlockId id, MemoryBlock *hole) {
+    if (id == NIL_BLOCK) {
+        hole->tree_left = NIL_BLOCK;
+        hole->tree_right = NIL_BLOCK;
+        hole_tree_update(alloc, hole);
+        return hole->id;
+    }
+    
+    MemoryBlock *node = block_at(alloc, id);
+    if (hole_tree_compare(block_size(hole), hole->start, node) < 0) {
+        node->tree_left = hole_tree_insert(alloc, node->tree_left, hole);
+    } else {
+        node->tree_right = hole_tree_insert(alloc, node->tree_right, hole);
+    }
+    return hole_tree_rebalance(alloc, id);
+}
+
+/**
+ * @brief Detach the minimum node of a subtree
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param id Subtree root
+ * @param min Output: detached minimum node
+ * @return New subtree root
+ */
+static BlockId hole_tree_detach_min(Allocator *alloc, BlockId id, MemoryBlock **min) {
+    MemoryBlock *node = block_at(alloc, id);
+    if (node->tree_left == NIL_BLOCK) {
+        *min = node;
+        return node->tree_right;
+    }
+    node->tree_left = hole_tree_detach_min(alloc, node->tree_left, min);
+    return hole_tree_rebalance(alloc, id);
+}
+
+/**
+ * @brief Remove a hole that was filed under the given key
+ * 
+ * The key is passed explicitly because callers may already have resized
+ * the hole in place before asking for it to be refiled, so the node itself
+ * is matched by identity rather than by its current fields.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param id Subtree root
+ * @param hole Hole to remove
+ * @param size Size the hole was indexed under
+ * @param start Start address the hole was indexed under
+ * @return New subtree root
+ */
+static BlockId hole_tree_remove(Allocator *alloc, BlockId id, MemoryBlock *hole, size_t size, size_t start) {
+    if (id == NIL_BLOCK) {
+        return NIL_BLOCK;
+    }
+    
+    MemoryBlock *node = block_at(alloc, id);
+    int cmp = (node == hole) ? 0 : hole_tree_compare(size, start, node);
+    if (cmp < 0) {
+        node->tree_left = hole_tree_remove(alloc, node->tree_left, hole, size, start);
+    } else if (cmp > 0) {
+        node->tree_right = hole_tree_remove(alloc, node->tree_right, hole, size, start);
+    } else {
+        BlockId left = node->tree_left;
+        BlockId right = node->tree_right;
+        node->tree_left = NIL_BLOCK;
+        node->tree_right = NIL_BLOCK;
+        
+        if (right == NIL_BLOCK) {
+            return left;
+        }
+        MemoryBlock *successor;
+        right = hole_tree_detach_min(alloc, right, &successor);
+        successor->tree_left = left;
+        successor->tree_right = right;
+        return hole_tree_rebalance(alloc, successor->id);
+    }
+    return hole_tree_rebalance(alloc, id);
+}
+
+/**
+ * @brief Find the first hole whose (size, start) key is at least the given one
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param id Tree root
+ * @param size Size part of the key
+ * @param start Start part of the key
+ * @return The hole, or NULL if every key is smaller
+ */
+static MemoryBlock *hole_tree_lower_bound(Allocator *alloc, BlockId id, size_t size, size_t start) {
+    MemoryBlock *found = NULL;
+    MemoryBlock *node = block_at(alloc, id);
+    while (node != NULL) {
+        alloc->probes++;
+        if (hole_tree_compare(size, start, node) <= 0) {
+            found = node;
+            node = block_at(alloc, node->tree_left);
+        } else {
+            node = block_at(alloc, node->tree_right);
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Find the smallest hole that fits an aligned block
+ * 
+ * This is a lower-bound lookup on (size, 0): the leftmost qualifying key
+ * is the smallest size and, among equal sizes, the lowest address. If the
+ * alignment does not leave room in that hole, the walk moves on to the
+ * next key; only holes under size + align - 1 bytes can fail, so the
+ * walk stays among holes within the alignment of the request's size, at
+ * O(log n) each.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param id Tree root
+ * @param size Requested size
+ * @param align Alignment of the block's start (a power of two)
+ * @return Matching hole, or NULL if none fits
+ */
+static MemoryBlock *hole_tree_best_fit(Allocator *alloc, BlockId id, size_t size, size_t align) {
+    MemoryBlock *best = hole_tree_lower_bound(alloc, id, size, 0);
+    while (best != NULL && !hole_fits(best, size, align)) {
+        best = hole_tree_lower_bound(alloc, id, block_size(best), best->start + 1);
+    }
+    return best;
+}
+
+/**
+ * @brief Find the largest hole, provided it fits an aligned block
+ * 
+ * The rightmost node has the largest size but the highest address among
+ * equals, so a second lower-bound lookup picks the lowest-addressed one.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param id Tree root
+ * @param size Requested size
+ * @param align Alignment of the block's start (a power of two)
+ * @return Matching hole, or NULL if the largest hole does not fit
+ */
+static MemoryBlock *hole_tree_worst_fit(Allocator *alloc, BlockId id, size_t size, size_t align) {
+    if (id == NIL_BLOCK) {
+        return NULL;
+    }
+    
+    MemoryBlock *largest = block_at(alloc, id);
+    while (largest->tree_right != NIL_BLOCK) {
+        alloc->probes++;
+        largest = block_at(alloc, largest->tree_right);
+    }
+    if (block_size(largest) < size) {
+        return NULL;
+    }
+    MemoryBlock *worst = hole_tree_lower_bound(alloc, id, block_size(largest), 0);
+    return hole_fits(worst, size, align) ? worst : NULL;
+}
+
+/**
+ * @brief Node holding the lowest hole address of a subtree
+ * 
+ * Follows the cached subtree minimums down from the subtree root.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param subtree Subtree root (NULL allowed)
+ * @return The lowest-addressed hole, or NULL for an empty subtree
+ */
+static MemoryBlock *hole_tree_lowest(Allocator *alloc, MemoryBlock *subtree) {
+    while (subtree != NULL && subtree->start != subtree->tree_min_start) {
+        alloc->probes++;
+        MemoryBlock *left = block_at(alloc, subtree->tree_left);
+        if (left != NULL && left->tree_min_start == subtree->tree_min_start) {
+            subtree = left;
+        } else {
+            subtree = block_at(alloc, subtree->tree_right);
+        }
+    }
+    return subtree;
+}
+
+/**
+ * @brief Find the lowest-addressed hole that fits an aligned block
+ * 
+ * Walking the lower-bound path for size + align - 1, every node that fits
+ * brings its whole right subtree along with it; the cached subtree minimum
+ * tells which of those candidates holds the lowest address without
+ * visiting them. With alignment, the smaller holes that still fit from
+ * their own start are then walked in key order, one lower-bound lookup
+ * each, so an aligned search costs O(log n) per hole of between size and
+ * size + align - 1 bytes. Looking up size + align - 1 alone would bound
+ * it, but would miss those holes and differ from a list scan.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param id Tree root
+ * @param size Requested size
+ * @param align Alignment of the block's start (a power of two)
+ * @return Matching hole, or NULL if none fits
+ */
+static MemoryBlock *hole_tree_first_fit(Allocator *alloc, BlockId id, size_t size, size_t align) {
+    size_t padded = padded_size(size, align);
+    MemoryBlock *first = NULL;
+    MemoryBlock *subtree = NULL;
+    size_t first_start = SIZE_MAX;
+    MemoryBlock *node = block_at(alloc, id);
+    
+    while (node != NULL) {
+        alloc->probes++;
+        if (block_size(node) >= padded) {
+            if (node->start < first_start) {
+                first = node;
+                subtree = NULL;
+                first_start = node->start;
+            }
+            MemoryBlock *right = block_at(alloc, node->tree_right);
+            if (right != NULL && right->tree_min_start < first_start) {
+                first = NULL;
+                subtree = right;
+                first_start = subtree->tree_min_start;
+            }
+            node = block_at(alloc, node->tree_left);
+        } else {
+            node = block_at(alloc, node->tree_right);
+        }
+    }
+    
+    if (first == NULL) {
+        first = hole_tree_lowest(alloc, subtree);
+    }
+    
+    // Holes too small to fit wherever they start may still fit where they do
+    if (align > 1) {
+        for (node = hole_tree_lower_bound(alloc, id, size, 0); node != NULL && block_size(node) < padded;
+             node = hole_tree_lower_bound(alloc, id, block_size(node), node->start + 1)) {
+            if (node->start < first_start && hole_fits(node, size, align)) {
+                first = node;
+                first_start = node->start;
+            }
+        }
+    }
+    return first;
+}
+
+/* ============================================================================
+ * ADDRESS INDEX
+ * ============================================================================ */
+
+/**
+ * @brief Insert an allocated block into the address subtree rooted at id
+ * 
+ * The address index is an AVL tree of the allocated blocks keyed by start
+ * address. It uses the same node fields and rotations as the hole tree,
+ * which only ever holds free blocks. Compaction changes start addresses
+ * but never their order, so it leaves the tree valid.
+ * 
+ * @return New subtree root
+ */
+static BlockId address_index_insert(Allocator *alloc, BlockId id, MemoryBlock *block) {
+    if (id == NIL_BLOCK) {
+        block->tree_left = NIL_BLOCK;
+        block->tree_right = NIL_BLOCK;
+        hole_tree_update(alloc, block);
+        return block->id;
+    }
+    
+    MemoryBlock *node = block_at(alloc, id);
+    if (block->start < node->start) {
+        node->tree_left = address_index_insert(alloc, node->tree_left, block);
+    } else {
+        node->tree_right = address_index_insert(alloc, node->tree_right, block);
+    }
+    return hole_tree_rebalance(alloc, id);
+}
+
+/**
+ * @brief Remove an allocated block from the address subtree rooted at id
+ * 
+ * @return New subtree root
+ */
+static BlockId address_index_remove(Allocator *alloc, BlockId id, MemoryBlock *block) {
+    if (id == NIL_BLOCK) {
+        return NIL_BLOCK;
+    }
+    
+    MemoryBlock *node = block_at(alloc, id);
+    if (node != block) {
+        if (block->start < node->start) {
+            node->tree_left = address_index_remove(alloc, node->tree_left, block);
+        } else {
+            node->tree_right = address_index_remove(alloc, node->tree_right, block);
+        }
+        return hole_tree_rebalance(alloc, id);
+    }
+    
+    BlockId left = node->tree_left;
+    BlockId right = node->tree_right;
+    node->tree_left = NIL_BLOCK;
+    node->tree_right = NIL_BLOCK;
+    if (right == NIL_BLOCK) {
+        return left;
+    }
+    MemoryBlock *successor;
+    right = hole_tree_detach_min(alloc, right, &successor);
+    successor->tree_left = left;
+    successor->tree_right = right;
+    return hole_tree_rebalance(alloc, successor->id);
+}
+
+/**
+ * @brief File a newly allocated block, if the address index is in use
+ */
+static void address_index_add(Allocator *alloc, MemoryBlock *block) {
+    if (alloc->address_index_active) {
+        alloc->address_tree = address_index_insert(alloc, alloc->address_tree, block);
+    }
+}
+
+/**
+ * @brief Drop a block that is about to be freed, if the address index is in use
+ */
+static void address_index_drop(Allocator *alloc, MemoryBlock *block) {
+    if (alloc->address_index_active) {
+        alloc->address_tree = address_index_remove(alloc, alloc->address_tree, block);
+    }
+}
+
+/**
+ * @brief Find the block containing an address in O(log n)
+ * 
+ * The list alone can only be searched from address 0, so on a large,
+ * sparsely used memory the index is what lets a query start where it is
+ * asked to. Only allocated blocks are filed; a hole is found as the
+ * neighbour of the allocated block below it.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param address Address in [0, total_size)
+ * @return Block covering the address, or NULL if it lies beyond the memory
+ */
+static MemoryBlock *address_index_find(Allocator *alloc, size_t address) {
+    if (!alloc->address_index_active) {
+        alloc->address_index_active = true;
+        for (MemoryBlock *current = first_block(alloc); current != NULL; current = next_block(alloc, current)) {
+            if (current->type == BLOCK_ALLOCATED) {
+                address_index_add(alloc, current);
+            }
+        }
+    }
+    
+    // Last allocated block starting at or below the address
+    MemoryBlock *floor = NULL;
+    MemoryBlock *node = block_at(alloc, alloc->address_tree);
+    while (node != NULL) {
+        if (node->start <= address) {
+            floor = node;
+            node = block_at(alloc, node->tree_right);
+        } else {
+            node = block_at(alloc, node->tree_left);
+        }
+    }
+    
+    MemoryBlock *block = (floor != NULL) ? floor : first_block(alloc);
+    while (block != NULL && block->end <= address) {
+        block = next_block(alloc, block);
+    }
+    return block;
+}
+
+/* ============================================================================
+ * FREE-HOLE INDEX
+ * ============================================================================ */
+
+/**
+ * @brief Find a hole by walking the whole block list (HOLE_INDEX_LIST)
+ * 
+ * Worst Fit picks the largest hole and then checks that the block fits,
+ * as the indexes do, rather than the largest of the holes that fit.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param size Requested size
+ * @param align Alignment of the block's start (a power of two)
+ * @param strategy Which hole to pick among those that fit
+ * @return Matching hole, or NULL if none fits
+ */
+static MemoryBlock *scan_block_list(Allocator *alloc, size_t size, size_t align, AllocationStrategy strategy) {
+    MemoryBlock *found = NULL;
+    
+    for (MemoryBlock *current = first_block(alloc); current != NULL; current = next_block(alloc, current)) {
+        alloc->probes++;
+        if (current->type != BLOCK_FREE) {
+            continue;
+        }
+        if (strategy == STRATEGY_WORST_FIT) {
+            if (found == NULL || block_size(current) > block_size(found)) {
+                found = current;
+            }
+            continue;
+        }
+        if (!hole_fits(current, size, align)) {
+            continue;
+        }
+        if (strategy == STRATEGY_FIRST_FIT) {
+            return current;
+        }
+        if (found == NULL || block_size(current) < block_size(found)) {
+            found = current;
+        }
+    }
+    
+    if (found != NULL && !hole_fits(found, size, align)) {
+        return NULL; // The largest hole is too small
+    }
+    return found;
+}
+
+/**
+ * @brief File a hole in the size classes or the hole tree, whichever is selected
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param hole Free block to index
+ */
+static void hole_index_file(Allocator *alloc, MemoryBlock *hole) {
+    switch (alloc->index_mode) {
+        case HOLE_INDEX_SEGREGATED:
+            free_list_insert(alloc, hole);
+            break;
+        case HOLE_INDEX_TREE:
+            alloc->hole_tree = hole_tree_insert(alloc, alloc->hole_tree, hole);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Add a hole to the active index
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param hole Free block to index
+ */
+static void hole_index_insert(Allocator *alloc, MemoryBlock *hole) {
+    alloc->total_free += block_size(hole);
+    alloc->hole_count++;
+    if (block_size(hole) >= alloc->largest_hole) {
+        alloc->largest_hole = block_size(hole);
+        alloc->largest_hole_valid = true;
+    }
+    
+    if (alloc->buddy.active) {
+        buddy_add_chunks(alloc, hole);
+    }
+    if (alloc->tlsf.active) {
+        tlsf_insert(alloc, hole);
+    }
+    if (alloc->occupancy.active) {
+        occupancy_mark(alloc, hole->start, hole->end, 1);
+    }
+    if (alloc->hole_index_active) {
+        hole_index_file(alloc, hole);
+    }
+}
+
+/**
+ * @brief Remove a hole from the index (it is being allocated or merged away)
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param hole Free block to drop from the index
+ */
+static void hole_index_remove(Allocator *alloc, MemoryBlock *hole) {
+    alloc->total_free -= block_size(hole);
+    alloc->hole_count--;
+    if (block_size(hole) == alloc->largest_hole) {
+        alloc->largest_hole_valid = false;
+    }
+    
+    if (alloc->buddy.active) {
+        buddy_drop_chunks(alloc, hole);
+    }
+    if (alloc->tlsf.active) {
+        tlsf_remove(alloc, hole, block_size(hole));
+    }
+    if (alloc->occupancy.active) {
+        occupancy_mark(alloc, hole->start, hole->end, -1);
+    }
+    switch (alloc->hole_index_active ? alloc->index_mode : HOLE_INDEX_LIST) {
+        case HOLE_INDEX_SEGREGATED:
+            free_list_remove(alloc, hole, block_size(hole), hole->start);
+            break;
+        case HOLE_INDEX_TREE:
+            alloc->hole_tree = hole_tree_remove(alloc, alloc->hole_tree, hole, block_size(hole), hole->start);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Refile a hole whose extent changed (split or merge)
+ * 
+ * The class trees and the hole tree are keyed by size, so the hole is
+ * always refiled, in O(log n).
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param hole Free block whose extent was updated
+ * @param old_start Start address the hole was indexed under
+ * @param old_size Size the hole was indexed under
+ */
+static void hole_index_resize(Allocator *alloc, MemoryBlock *hole, size_t old_start, size_t old_size) {
+    alloc->total_free += block_size(hole) - old_size;
+    if (block_size(hole) >= alloc->largest_hole) {
+        alloc->largest_hole = block_size(hole);
+        alloc->largest_hole_valid = true;
+    } else if (old_size == alloc->largest_hole && block_size(hole) < old_size) {
+        alloc->largest_hole_valid = false;
+    }
+    
+    if (alloc->buddy.active) {
+        buddy_drop_chunks(alloc, hole);
+        buddy_add_chunks(alloc, hole);
+    }
+    if (alloc->tlsf.active) {
+        tlsf_remove(alloc, hole, old_size);
+        tlsf_insert(alloc, hole);
+    }
+    if (alloc->occupancy.active) {
+        occupancy_mark(alloc, old_start, old_start + old_size, -1);
+        occupancy_mark(alloc, hole->start, hole->end, 1);
+    }
+    switch (alloc->hole_index_active ? alloc->index_mode : HOLE_INDEX_LIST) {
+        case HOLE_INDEX_SEGREGATED:
+            free_list_remove(alloc, hole, old_size, old_start);
+            free_list_insert(alloc, hole);
+            break;
+        case HOLE_INDEX_TREE:
+            alloc->hole_tree = hole_tree_remove(alloc, alloc->hole_tree, hole, old_size, old_start);
+            alloc->hole_tree = hole_tree_insert(alloc, alloc->hole_tree, hole);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Empty the index (the block list is being rebuilt or torn down)
+ * 
+ * @param alloc Pointer to Allocator structure
+ */
+static void hole_index_reset(Allocator *alloc) {
+    for (int i = 0; i < SIZE_CLASS_COUNT; i++) {
+        alloc->free_lists[i] = NIL_BLOCK;
+    }
+    alloc->free_list_map = 0;
+    alloc->hole_tree = NIL_BLOCK;
+    alloc->hole_index_active = false;
+    buddy_index_clear(&alloc->buddy);
+    tlsf_index_clear(&alloc->tlsf);
+}
+
+/**
+ * @brief File every hole in the selected index, on the first F, B or W search
+ * 
+ * Until then the largest hole comes from largest_hole_size().
+ * 
+ * @param alloc Pointer to Allocator structure
+ */
+static void hole_index_build(Allocator *alloc) {
+    if (alloc->hole_index_active || alloc->index_mode == HOLE_INDEX_LIST) {
+        return;
+    }
+    for (MemoryBlock *current = first_block(alloc); current != NULL; current = next_block(alloc, current)) {
+        if (current->type == BLOCK_FREE) {
+            hole_index_file(alloc, current);
+        }
+    }
+    alloc->hole_index_active = true;
+}
+
+/**
+ * @brief Find the lowest-addressed hole that fits an aligned block
+ */
+static MemoryBlock *find_first_fit_hole(Allocator *alloc, size_t size, size_t align) {
+    hole_index_build(alloc);
+    switch (alloc->index_mode) {
+        case HOLE_INDEX_SEGREGATED:
+            return free_list_first_fit(alloc, size, align);
+        case HOLE_INDEX_TREE:
+            return hole_tree_first_fit(alloc, alloc->hole_tree, size, align);
+        default:
+            return scan_block_list(alloc, size, align, STRATEGY_FIRST_FIT);
+    }
+}
+
+/**
+ * @brief Find the smallest hole that fits an aligned block (lowest address on ties)
+ */
+static MemoryBlock *find_best_fit_hole(Allocator *alloc, size_t size, size_t align) {
+    hole_index_build(alloc);
+    switch (alloc->index_mode) {
+        case HOLE_INDEX_SEGREGATED:
+            return free_list_best_fit(alloc, size, align);
+        case HOLE_INDEX_TREE:
+            return hole_tree_best_fit(alloc, alloc->hole_tree, size, align);
+        default:
+            return scan_block_list(alloc, size, align, STRATEGY_BEST_FIT);
+    }
+}
+
+/**
+ * @brief Find the largest hole if it fits an aligned block (lowest address on ties)
+ */
+static MemoryBlock *find_worst_fit_hole(Allocator *alloc, size_t size, size_t align) {
+    hole_index_build(alloc);
+    switch (alloc->index_mode) {
+        case HOLE_INDEX_SEGREGATED:
+            return free_list_worst_fit(alloc, size, align);
+        case HOLE_INDEX_TREE:
+            return hole_tree_worst_fit(alloc, alloc->hole_tree, size, align);
+        default:
+            return scan_block_list(alloc, size, align, STRATEGY_WORST_FIT);
+    }
+}
+
+/**
+ * @brief Size of the largest hole
+ * 
+ * The hole index hooks keep largest_hole exact until the hole it describes
+ * shrinks or is removed; only then is the largest hole looked up again
+ * through the index (the top size class, the tree's maximum, or a list
+ * walk with --index=list). While no F, B or W search has built that index
+ * but the TLSF lists are kept, the top TLSF list is read instead, so a
+ * T-only trace never pays for the other index. Otherwise the index is
+ * built here, once.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @return Size of the largest hole, or 0 if memory is full
+ */
+static size_t largest_hole_size(Allocator *alloc) {
+    if (!alloc->largest_hole_valid) {
+        MemoryBlock *largest = (!alloc->hole_index_active && alloc->tlsf.active) ? tlsf_largest(alloc)
+                                                                                 : find_worst_fit_hole(alloc, 1, 1);
+        alloc->largest_hole = (largest != NULL) ? block_size(largest) : 0;
+        alloc->largest_hole_valid = true;
+    }
+    return alloc->largest_hole;
+}
+
+/**
+ * @brief Largest block a hole in a subtree of the hole tree could hold on a multiple of align
+ * 
+ * Holes are visited from the largest down, and the walk stops at the
+ * first one no larger than the best block found: no hole below it can
+ * hold more. Since the largest hole alone holds all but align - 1 of its
+ * bytes, only holes within align - 1 bytes of it are looked at.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param id Root of the subtree
+ * @param align Alignment of the block's start (a power of two)
+ * @param best Largest block found so far
+ * @return Largest block found, or best if the subtree holds none larger
+ */
+static size_t hole_tree_largest_aligned(Allocator *alloc, BlockId id, size_t align, size_t best) {
+    while (id != NIL_BLOCK) {
+        MemoryBlock *node = block_at(alloc, id);
+        best = hole_tree_largest_aligned(alloc, node->tree_right, align, best);
+        if (block_size(node) <= best) {
+            break;
+        }
+        size_t padding = align_padding(node->start, align);
+        if (block_size(node) > padding && block_size(node) - padding > best) {
+            best = block_size(node) - padding;
+        }
+        id = node->tree_left;
+    }
+    return best;
+}
+
+/**
+ * @brief Largest block any hole could hold on a multiple of align
+ * 
+ * Without alignment this is the largest hole. Otherwise the index is
+ * read from its largest holes down with hole_tree_largest_aligned(); the
+ * segregated classes stop at the first one whose holes are all too small
+ * to beat the best block found. Before the index is built the whole
+ * list is walked.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param align Alignment of the block's start (a power of two)
+ * @return Size of the largest aligned block, or 0 if no hole holds one
+ */
+static size_t largest_aligned_block(Allocator *alloc, size_t align) {
+    if (align <= 1) {
+        return largest_hole_size(alloc);
+    }
+    if (alloc->hole_index_active && alloc->index_mode == HOLE_INDEX_TREE) {
+        return hole_tree_largest_aligned(alloc, alloc->hole_tree, align, 0);
+    }
+    
+    size_t best = 0;
+    if (alloc->hole_index_active && alloc->index_mode == HOLE_INDEX_SEGREGATED) {
+        uint64_t classes = alloc->free_list_map;
+        while (classes != 0) {
+            int cls = 63 - __builtin_clzll(classes);
+            if (cls < SIZE_CLASS_COUNT - 1 && ((size_t)2 << cls) - 1 <= best) {
+                break; // Every hole in this class and below is at most best bytes
+            }
+            best = hole_tree_largest_aligned(alloc, alloc->free_lists[cls], align, best);
+            classes &= ~(1ULL << cls);
+        }
+        return best;
+    }
+    
+    for (MemoryBlock *current = first_block(alloc); current != NULL; current = next_block(alloc, current)) {
+        size_t padding = align_padding(current->start, align);
+        if (current->type == BLOCK_FREE && block_size(current) > padding && block_size(current) - padding > best) {
+            best = block_size(current) - padding;
+        }
+    }
+    return best;
+}
+
+/* ============================================================================
+ * BUDDY SYSTEM
+ * ============================================================================ */
+
+/**
+ * @brief Smallest order whose block holds the given size (ceil(log2(size)))
+ * 
+ * @param size Requested size (at least 1)
+ * @return Order k such that 2^(k-1) < size <= 2^k
+ */
+static int buddy_order(size_t size) {
+    if (size <= 1) {
+        return 0;
+    }
+    return 64 - __builtin_clzll((unsigned long long)(size - 1));
+}
+
+/**
+ * @brief Take a chunk slot, growing the chunk array if none is free
+ * 
+ * @param buddy Pointer to BuddyIndex structure
+ * @return Chunk id, or 0 if the array could not be grown
+ */
+static ChunkId buddy_chunk_alloc(BuddyIndex *buddy) {
+    if (buddy->free_chunks != 0) {
+        ChunkId id = buddy->free_chunks;
+        buddy->free_chunks = buddy->chunks[id - 1].next;
+        return id;
+    }
+    
+    if (buddy->chunk_count == buddy->chunk_capacity) {
+        if (!buddy_index_unmap(buddy)) {
+            return 0;
+        }
+        ChunkId new_capacity = (buddy->chunk_capacity == 0) ? 256 : buddy->chunk_capacity * 2;
+        BuddyChunk *new_chunks = (BuddyChunk *)realloc(buddy->chunks, new_capacity * sizeof(BuddyChunk));
+        if (new_chunks == NULL) {
+            return 0;
+        }
+        buddy->chunks = new_chunks;
+        buddy->chunk_capacity = new_capacity;
+    }
+    return ++buddy->chunk_count;
+}
+
+/**
+ * @brief File the buddy chunks that a hole decomposes into
+ * 
+ * Starting from the hole's start, each step takes the largest power-of-two
+ * block that is aligned to its own size and still fits. This yields the
+ * same free blocks a classic buddy allocator would hold for that range:
+ * a split leaves buddies of every order below the one split, and a hole
+ * that grows by merging is decomposed again into the larger blocks.
+ * 
+ * If a chunk slot cannot be allocated the index is switched off; the next
+ * Y request rebuilds it from the block list.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param hole Free block to decompose
+ */
+static void buddy_add_chunks(Allocator *alloc, MemoryBlock *hole) {
+    BuddyIndex *buddy = &alloc->buddy;
+    hole->buddy_chunks = 0;
+    
+    for (size_t pos = hole->start; pos < hole->end; ) {
+        int order = 63 - __builtin_clzll((unsigned long long)(hole->end - pos));
+        if (pos != 0 && __builtin_ctzll((unsigned long long)pos) < order) {
+            order = __builtin_ctzll((unsigned long long)pos);
+        }
+        
+        ChunkId id = buddy_chunk_alloc(buddy);
+        if (id == 0) {
+            buddy_index_clear(buddy);
+            buddy->active = false;
+            return;
+        }
+        
+        BuddyChunk *chunk = &buddy->chunks[id - 1];
+        chunk->start = pos;
+        chunk->order = (uint8_t)order;
+        chunk->hole = hole->id;
+        chunk->sibling = hole->buddy_chunks;
+        hole->buddy_chunks = id;
+        
+        chunk->prev = 0;
+        chunk->next = buddy->free_lists[order];
+        if (chunk->next != 0) {
+            buddy->chunks[chunk->next - 1].prev = id;
+        }
+        buddy->free_lists[order] = id;
+        buddy->order_map |= 1ULL << order;
+        
+        pos += (size_t)1 << order;
+    }
+}
+
+/**
+ * @brief Remove a hole's chunks from the per-order free lists
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param hole Free block whose extent is about to change or disappear
+ */
+static void buddy_drop_chunks(Allocator *alloc, MemoryBlock *hole) {
+    BuddyIndex *buddy = &alloc->buddy;
+    ChunkId id = hole->buddy_chunks;
+    
+    while (id != 0) {
+        BuddyChunk *chunk = &buddy->chunks[id - 1];
+        ChunkId sibling = chunk->sibling;
+        
+        if (chunk->prev != 0) {
+            buddy->chunks[chunk->prev - 1].next = chunk->next;
+        } else {
+            buddy->free_lists[chunk->order] = chunk->next;
+            if (chunk->next == 0) {
+                buddy->order_map &= ~(1ULL << chunk->order);
+            }
+        }
+        if (chunk->next != 0) {
+            buddy->chunks[chunk->next - 1].prev = chunk->prev;
+        }
+        
+        chunk->next = buddy->free_chunks;
+        buddy->free_chunks = id;
+        id = sibling;
+    }
+    hole->buddy_chunks = 0;
+}
+
+/**
+ * @brief Start maintaining the buddy chunk lists from the current holes
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @return true on success, false if chunk storage could not be allocated
+ */
+static bool buddy_index_build(Allocator *alloc) {
+    buddy_index_clear(&alloc->buddy);
+    alloc->buddy.active = true;
+    
+    for (MemoryBlock *current = first_block(alloc); current != NULL && alloc->buddy.active;
+         current = next_block(alloc, current)) {
+        if (current->type == BLOCK_FREE) {
+            buddy_add_chunks(alloc, current);
+        }
+    }
+    return alloc->buddy.active;
+}
+
+/**
+ * @brief Drop every chunk (the holes are being rebuilt or torn down)
+ * 
+ * @param buddy Pointer to BuddyIndex structure
+ */
+static void buddy_index_clear(BuddyIndex *buddy) {
+    for (int i = 0; i < SIZE_CLASS_COUNT; i++) {
+        buddy->free_lists[i] = 0;
+    }
+    buddy->order_map = 0;
+    buddy->chunk_count = 0;
+    buddy->free_chunks = 0;
+}
+
+/**
+ * @brief Move chunk storage that lives in a snapshot to the heap, so it can grow
+ * 
+ * @param buddy Pointer to BuddyIndex structure
+ * @return true on success, false if memory ran out
+ */
+static bool buddy_index_unmap(BuddyIndex *buddy) {
+    if (!buddy->mapped) {
+        return true;
+    }
+    bool ok = true;
+    BuddyChunk *chunks = (BuddyChunk *)clone_array(buddy->chunks, buddy->chunk_capacity * sizeof(BuddyChunk), &ok);
+    if (!ok) {
+        return false;
+    }
+    buddy->chunks = chunks;
+    buddy->mapped = false;
+    return true;
+}
+
+/**
+ * @brief Release the chunk storage
+ * 
+ * @param buddy Pointer to BuddyIndex structure
+ */
+static void buddy_index_destroy(BuddyIndex *buddy) {
+    if (!buddy->mapped) {
+        free(buddy->chunks);
+    }
+    memset(buddy, 0, sizeof(BuddyIndex));
+}
+
+/* ============================================================================
+ * TWO-LEVEL SEGREGATED FIT
+ * ============================================================================ */
+
+/**
+ * @brief Map a hole size to its TLSF (first level, second level) list
+ * 
+ * Sizes below TLSF_SL_COUNT each get their own list in first level 0.
+ * Above that, first level f covers [2^(f+3), 2^(f+4)) and the second
+ * level splits that range into TLSF_SL_COUNT equal parts.
+ * 
+ * @param size Hole size in bytes
+ * @param fl Output: first-level index
+ * @param sl Output: second-level index
+ */
+static void tlsf_mapping(size_t size, int *fl, int *sl) {
+    if (size < TLSF_SL_COUNT) {
+        *fl = 0;
+        *sl = (int)size;
+        return;
+    }
+    int log2 = 63 - __builtin_clzll((unsigned long long)size);
+    *fl = log2 - TLSF_SL_LOG2 + 1;
+    *sl = (int)((size >> (log2 - TLSF_SL_LOG2)) - TLSF_SL_COUNT);
+}
+
+/**
+ * @brief Make sure the link arrays can be indexed by a block id
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param id Block id about to be linked
+ * @return true on success, false if the arrays could not be grown
+ */
+static bool tlsf_reserve_links(Allocator *alloc, BlockId id) {
+    TlsfIndex *tlsf = &alloc->tlsf;
+    if (id < tlsf->link_capacity) {
+        return true;
+    }
+    
+    if (!tlsf_index_unmap(tlsf)) {
+        return false;
+    }
+    size_t new_capacity = alloc->pool.slab_count * BLOCK_POOL_SLAB_SIZE + 1;
+    BlockId *new_next = (BlockId *)realloc(tlsf->next, new_capacity * sizeof(BlockId));
+    if (new_next == NULL) {
+        return false;
+    }
+    tlsf->next = new_next;
+    BlockId *new_prev = (BlockId *)realloc(tlsf->prev, new_capacity * sizeof(BlockId));
+    if (new_prev == NULL) {
+        return false;
+    }
+    tlsf->prev = new_prev;
+    tlsf->link_capacity = new_capacity;
+    return true;
+}
+
+/**
+ * @brief Push a hole onto the head of its TLSF list
+ * 
+ * If the link arrays cannot be grown the index is switched off; the next
+ * T request rebuilds it from the block list.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param hole Free block to index
+ */
+static void tlsf_insert(Allocator *alloc, MemoryBlock *hole) {
+    TlsfIndex *tlsf = &alloc->tlsf;
+    if (!tlsf_reserve_links(alloc, hole->id)) {
+        tlsf_index_clear(tlsf);
+        tlsf->active = false;
+        return;
+    }
+    
+    int fl, sl;
+    tlsf_mapping(block_size(hole), &fl, &sl);
+    BlockId head = tlsf->heads[fl][sl];
+    tlsf->next[hole->id] = head;
+    tlsf->prev[hole->id] = NIL_BLOCK;
+    if (head != NIL_BLOCK) {
+        tlsf->prev[head] = hole->id;
+    }
+    tlsf->heads[fl][sl] = hole->id;
+    tlsf->sl_map[fl] |= 1u << sl;
+    tlsf->fl_map |= 1ULL << fl;
+}
+
+/**
+ * @brief Unlink a hole from the TLSF list it was filed under
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param hole Free block to unlink
+ * @param size Size the hole was filed under
+ */
+static void tlsf_remove(Allocator *alloc, MemoryBlock *hole, size_t size) {
+    TlsfIndex *tlsf = &alloc->tlsf;
+    BlockId next = tlsf->next[hole->id];
+    BlockId prev = tlsf->prev[hole->id];
+    int fl, sl;
+    tlsf_mapping(size, &fl, &sl);
+    
+    if (prev != NIL_BLOCK) {
+        tlsf->next[prev] = next;
+    } else {
+        tlsf->heads[fl][sl] = next;
+        if (next == NIL_BLOCK) {
+            tlsf->sl_map[fl] &= ~(1u << sl);
+            if (tlsf->sl_map[fl] == 0) {
+                tlsf->fl_map &= ~(1ULL << fl);
+            }
+        }
+    }
+    if (next != NIL_BLOCK) {
+        tlsf->prev[next] = prev;
+    }
+}
+
+/**
+ * @brief Find a hole of at least the given size in constant time
+ * 
+ * The request is rounded up to the start of the next second-level range,
+ * so every hole in the list found is large enough and only list heads are
+ * ever looked at. As in any TLSF allocator, a hole that fits but shares
+ * the request's own second-level range is not considered.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param size Requested size
+ * @return Matching hole, or NULL if none was found
+ */
+static MemoryBlock *tlsf_find(Allocator *alloc, size_t size) {
+    TlsfIndex *tlsf = &alloc->tlsf;
+    
+    if (size >= TLSF_SL_COUNT) {
+        int log2 = 63 - __builtin_clzll((unsigned long long)size);
+        size_t round = ((size_t)1 << (log2 - TLSF_SL_LOG2)) - 1;
+        if (size > SIZE_MAX - round) {
+            return NULL;
+        }
+        size += round;
+    }
+    
+    int fl, sl;
+    tlsf_mapping(size, &fl, &sl);
+    uint32_t sl_bits = tlsf->sl_map[fl] & (~0u << sl);
+    if (sl_bits == 0) {
+        uint64_t fl_bits = (fl + 1 < TLSF_FL_COUNT) ? tlsf->fl_map & (~0ULL << (fl + 1)) : 0;
+        if (fl_bits == 0) {
+            return NULL;
+        }
+        fl = __builtin_ctzll(fl_bits);
+        sl_bits = tlsf->sl_map[fl];
+    }
+    alloc->probes++;
+    return block_at(alloc, tlsf->heads[fl][__builtin_ctz(sl_bits)]);
+}
+
+/**
+ * @brief Find the largest hole from the TLSF lists
+ * 
+ * The largest hole is in the highest non-empty list, which the bitmaps
+ * give at once; only that list, whose holes all lie within one
+ * second-level range, is walked.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @return The largest hole, or NULL if there are none
+ */
+static MemoryBlock *tlsf_largest(Allocator *alloc) {
+    TlsfIndex *tlsf = &alloc->tlsf;
+    if (tlsf->fl_map == 0) {
+        return NULL;
+    }
+    
+    int fl = 63 - __builtin_clzll(tlsf->fl_map);
+    int sl = 31 - __builtin_clz(tlsf->sl_map[fl]);
+    MemoryBlock *largest = NULL;
+    for (BlockId id = tlsf->heads[fl][sl]; id != NIL_BLOCK; id = tlsf->next[id]) {
+        MemoryBlock *current = block_at(alloc, id);
+        if (largest == NULL || block_size(current) > block_size(largest)) {
+            largest = current;
+        }
+    }
+    return largest;
+}
+
+/**
+ * @brief Start maintaining the TLSF lists from the current holes
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @return true on success, false if the link arrays could not be allocated
+ */
+static bool tlsf_index_build(Allocator *alloc) {
+    tlsf_index_clear(&alloc->tlsf);
+    alloc->tlsf.active = true;
+    
+    for (MemoryBlock *current = first_block(alloc); current != NULL && alloc->tlsf.active;
+         current = next_block(alloc, current)) {
+        if (current->type == BLOCK_FREE) {
+            tlsf_insert(alloc, current);
+        }
+    }
+    return alloc->tlsf.active;
+}
+
+/**
+ * @brief Empty every list (the holes are being rebuilt or torn down)
+ * 
+ * @param tlsf Pointer to TlsfIndex structure
+ */
+static void tlsf_index_clear(TlsfIndex *tlsf) {
+    memset(tlsf->heads, 0, sizeof(tlsf->heads));
+    memset(tlsf->sl_map, 0, sizeof(tlsf->sl_map));
+    tlsf->fl_map = 0;
+}
+
+/**
+ * @brief Move link arrays that live in a snapshot to the heap, so they can grow
+ * 
+ * @param tlsf Pointer to TlsfIndex structure
+ * @return true on success, false if memory ran out
+ */
+static bool tlsf_index_unmap(TlsfIndex *tlsf) {
+    if (!tlsf->mapped) {
+        return true;
+    }
+    bool ok = true;
+    BlockId *next = (BlockId *)clone_array(tlsf->next, tlsf->link_capacity * sizeof(BlockId), &ok);
+    BlockId *prev = (BlockId *)clone_array(tlsf->prev, tlsf->link_capacity * sizeof(BlockId), &ok);
+    if (!ok) {
+        free(next);
+        free(prev);
+        return false;
+    }
+    tlsf->next = next;
+    tlsf->prev = prev;
+    tlsf->mapped = false;
+    return true;
+}
+
+/**
+ * @brief Release the link arrays
+ * 
+ * @param tlsf Pointer to TlsfIndex structure
+ */
+static void tlsf_index_destroy(TlsfIndex *tlsf) {
+    if (!tlsf->mapped) {
+        free(tlsf->next);
+        free(tlsf->prev);
+    }
+    memset(tlsf, 0, sizeof(TlsfIndex));
+}
+
+/* ============================================================================
+ * OCCUPANCY TREE
+ * ============================================================================ */
+
+/**
+ * @brief Bytes of [lo, hi) that lie inside the managed memory
+ */
+static inline size_t occupancy_span(const Allocator *alloc, size_t lo, size_t hi) {
+    if (lo >= alloc->total_size) {
+        return 0;
+    }
+    return ((hi < alloc->total_size) ? hi : alloc->total_size) - lo;
+}
+
+/**
+ * @brief Add or take away the free bytes of [start, end) below a node
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param node Node covering [lo, hi)
+ * @param lo Start of the node's range
+ * @param hi End of the node's range
+ * @param start Start of the hole
+ * @param end End of the hole
+ * @param delta 1 if the range became free, -1 if it stopped being free
+ */
+static void occupancy_update(Allocator *alloc, size_t node, size_t lo, size_t hi,
+                             size_t start, size_t end, int delta) {
+    OccupancyTree *tree = &alloc->occupancy;
+    if (end <= lo || hi <= start) {
+        return;
+    }
+    
+    bool leaf = node >= tree->leaf_count;
+    if (start <= lo && hi <= end && !leaf) {
+        tree->pending[node] += delta;
+        tree->free_bytes[node] += delta * (int64_t)occupancy_span(alloc, lo, hi);
+        return;
+    }
+    if (leaf) {
+        size_t from = (start > lo) ? start : lo;
+        size_t to = (end < hi) ? end : hi;
+        tree->free_bytes[node] += delta * (int64_t)occupancy_span(alloc, from, to);
+        return;
+    }
+    
+    size_t mid = lo + (hi - lo) / 2;
+    occupancy_update(alloc, 2 * node, lo, mid, start, end, delta);
+    occupancy_update(alloc, 2 * node + 1, mid, hi, start, end, delta);
+    tree->free_bytes[node] = tree->free_bytes[2 * node] + tree->free_bytes[2 * node + 1] +
+                             tree->pending[node] * (int64_t)occupancy_span(alloc, lo, hi);
+}
+
+/**
+ * @brief Record that [start, end) became free (delta 1) or was taken (delta -1)
+ */
+static void occupancy_mark(Allocator *alloc, size_t start, size_t end, int delta) {
+    const OccupancyTree *tree = &alloc->occupancy;
+    occupancy_update(alloc, 1, 0, tree->leaf_count * tree->leaf_size, start, end, delta);
+}
+
+/**
+ * @brief Free bytes of [start, end) below a node
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param node Node covering [lo, hi)
+ * @param lo Start of the node's range
+ * @param hi End of the node's range
+ * @param start Start of the range asked about
+ * @param end End of the range asked about
+ * @param covering Pending holes of the node's ancestors, which cover it whole
+ * @return Free bytes, exact unless a mixed leaf is only partly inside the range
+ */
+static int64_t occupancy_free_bytes(const Allocator *alloc, size_t node, size_t lo, size_t hi,
+                                    size_t start, size_t end, int64_t covering) {
+    const OccupancyTree *tree = &alloc->occupancy;
+    if (end <= lo || hi <= start) {
+        return 0;
+    }
+    
+    int64_t node_free = tree->free_bytes[node] + covering * (int64_t)occupancy_span(alloc, lo, hi);
+    if (start <= lo && hi <= end) {
+        return node_free;
+    }
+    if (node >= tree->leaf_count) {
+        size_t from = (start > lo) ? start : lo;
+        size_t to = (end < hi) ? end : hi;
+        int64_t span = (int64_t)occupancy_span(alloc, lo, hi);
+        int64_t part = (int64_t)occupancy_span(alloc, from, to);
+        if (node_free <= 0 || node_free >= span) {
+            return (node_free <= 0) ? 0 : part;
+        }
+        // A mixed leaf stays mixed in any part of two bytes or more
+        int64_t estimate = (int64_t)((double)node_free * (double)part / (double)span);
+        if (part >= 2) {
+            estimate = (estimate < 1) ? 1 : (estimate > part - 1) ? part - 1 : estimate;
+        }
+        return estimate;
+    }
+    
+    size_t mid = lo + (hi - lo) / 2;
+    covering += tree->pending[node];
+    return occupancy_free_bytes(alloc, 2 * node, lo, mid, start, end, covering) +
+           occupancy_free_bytes(alloc, 2 * node + 1, mid, hi, start, end, covering);
+}
+
+/**
+ * @brief Build the tree from the block list and start maintaining it
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @return true on success, false if memory could not be allocated
+ */
+static bool occupancy_build(Allocator *alloc) {
+    OccupancyTree *tree = &alloc->occupancy;
+    size_t leaves = 1;
+    while (leaves < alloc->total_size && leaves < OCCUPANCY_MAX_LEAVES) {
+        leaves *= 2;
+    }
+    tree->free_bytes = (int64_t *)calloc(2 * leaves, sizeof(int64_t));
+    tree->pending = (int32_t *)calloc(2 * leaves, sizeof(int32_t));
+    if (tree->free_bytes == NULL || tree->pending == NULL) {
+        occupancy_destroy(tree);
+        return false;
+    }
+    tree->leaf_count = leaves;
+    tree->leaf_size = alloc->total_size / leaves + (alloc->total_size % leaves != 0);
+    tree->active = true;
+    
+    for (MemoryBlock *block = first_block(alloc); block != NULL; block = next_block(alloc, block)) {
+        if (block->type == BLOCK_FREE) {
+            occupancy_mark(alloc, block->start, block->end, 1);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Release the tree and stop maintaining it
+ * 
+ * @param tree Pointer to OccupancyTree structure
+ */
+static void occupancy_destroy(OccupancyTree *tree) {
+    free(tree->free_bytes);
+    free(tree->pending);
+    memset(tree, 0, sizeof(OccupancyTree));
+}
+
+/* ============================================================================
+ * PROCESS NAME TABLE
+ * ============================================================================ */
+
+/**
+ * @brief Hash a process name (32-bit FNV-1a)
+ * 
+ * @param name Process name
+ * @return Hash value
+ */
+static uint32_t hash_name(const char *name) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)name; *p != '\0'; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Locate the slot holding a name, or the empty slot where it would go
+ * 
+ * The table uses linear probing and is never more than half full, so a
+ * probe sequence always reaches an empty slot. Names are never removed,
+ * so no tombstones or backward shifts are needed.
+ * 
+ * @param names Pointer to NameTable structure
+ * @param name Process name to look for
+ * @return Slot index
+ */
+static size_t name_table_slot(const NameTable *names, const char *name) {
+    size_t mask = names->slot_capacity - 1;
+    size_t slot = hash_name(name) & mask;
+    
+    while (names->slots[slot] != NO_NAME &&
+           strcmp(names->chars + names->offsets[names->slots[slot]], name) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/**
+ * @brief Set up an empty table holding only NO_NAME (the empty string)
+ * 
+ * @param names Pointer to NameTable structure
+ * @return true on success, false if memory could not be allocated
+ */
+static bool name_table_init(NameTable *names) {
+    memset(names, 0, sizeof(NameTable));
+    names->chars = (char *)malloc(MAX_PROCESS_NAME_LENGTH * NAME_TABLE_MIN_CAPACITY);
+    names->offsets = (size_t *)malloc(NAME_TABLE_MIN_CAPACITY * sizeof(size_t));
+    names->owners = (BlockId *)malloc(NAME_TABLE_MIN_CAPACITY * sizeof(BlockId));
+    names->requested = (size_t *)malloc(NAME_TABLE_MIN_CAPACITY * sizeof(size_t));
+    names->slots = (NameId *)calloc(NAME_TABLE_MIN_CAPACITY, sizeof(NameId));
+    if (names->chars == NULL || names->offsets == NULL || names->owners == NULL ||
+        names->requested == NULL || names->slots == NULL) {
+        name_table_destroy(names);
+        return false;
+    }
+    
+    names->chars_capacity = MAX_PROCESS_NAME_LENGTH * NAME_TABLE_MIN_CAPACITY;
+    names->id_capacity = NAME_TABLE_MIN_CAPACITY;
+    names->slot_capacity = NAME_TABLE_MIN_CAPACITY;
+    
+    // Id 0 is the empty name carried by holes
+    names->chars[0] = '\0';
+    names->chars_used = 1;
+    names->offsets[NO_NAME] = 0;
+    names->owners[NO_NAME] = NIL_BLOCK;
+    names->requested[NO_NAME] = 0;
+    names->count = 1;
+    return true;
+}
+
+/**
+ * @brief Find the id of an interned name
+ * 
+ * @param names Pointer to NameTable structure
+ * @param name Process name
+ * @return The name's id, or NO_NAME if it has never been interned
+ */
+static NameId name_table_lookup(const NameTable *names, const char *name) {
+    return names->slots[name_table_slot(names, name)];
+}
+
+/**
+ * @brief Intern a name, returning its existing id if it has been seen before
+ * 
+ * @param names Pointer to NameTable structure
+ * @param name Process name (shorter than MAX_PROCESS_NAME_LENGTH)
+ * @return The name's id, or NO_NAME if the table could not be grown
+ */
+static NameId name_table_intern(NameTable *names, const char *name) {
+    size_t slot = name_table_slot(names, name);
+    if (names->slots[slot] != NO_NAME) {
+        return names->slots[slot];
+    }
+    
+    size_t length = strlen(name) + 1;
+    if (names->chars_used + length > names->chars_capacity) {
+        if (!name_table_unmap(names)) {
+            return NO_NAME;
+        }
+        size_t new_capacity = names->chars_capacity * 2;
+        char *new_chars = (char *)realloc(names->chars, new_capacity);
+        if (new_chars == NULL) {
+            return NO_NAME;
+        }
+        names->chars = new_chars;
+        names->chars_capacity = new_capacity;
+    }
+    
+    if (names->count == names->id_capacity) {
+        if (!name_table_unmap(names)) {
+            return NO_NAME;
+        }
+        NameId new_capacity = names->id_capacity * 2;
+        size_t *new_offsets = (size_t *)realloc(names->offsets, new_capacity * sizeof(size_t));
+        if (new_offsets == NULL) {
+            return NO_NAME;
+        }
+        names->offsets = new_offsets;
+        BlockId *new_owners = (BlockId *)realloc(names->owners, new_capacity * sizeof(BlockId));
+        if (new_owners == NULL) {
+            return NO_NAME;
+        }
+        names->owners = new_owners;
+        size_t *new_requested = (size_t *)realloc(names->requested, new_capacity * sizeof(size_t));
+        if (new_requested == NULL) {
+            return NO_NAME;
+        }
+        names->requested = new_requested;
+        names->id_capacity = new_capacity;
+    }
+    
+    // Keep the hash table at most half full
+    if (((size_t)names->count + 1) * 2 > names->slot_capacity) {
+        if (!name_table_unmap(names)) {
+            return NO_NAME;
+        }
+        size_t new_capacity = names->slot_capacity * 2;
+        NameId *new_slots = (NameId *)calloc(new_capacity, sizeof(NameId));
+        if (new_slots == NULL) {
+            return NO_NAME;
+        }
+        free(names->slots);
+        names->slots = new_slots;
+        names->slot_capacity = new_capacity;
+        for (NameId id = 1; id < names->count; id++) {
+            names->slots[name_table_slot(names, names->chars + names->offsets[id])] = id;
+        }
+        slot = name_table_slot(names, name);
+    }
+    
+    NameId id = names->count++;
+    memcpy(names->chars + names->chars_used, name, length);
+    names->offsets[id] = names->chars_used;
+    names->chars_used += length;
+    names->owners[id] = NIL_BLOCK;
+    names->requested[id] = 0;
+    names->slots[slot] = id;
+    return id;
+}
+
+/**
+ * @brief Move arrays that live in a snapshot to the heap, so they can grow
+ * 
+ * @param names Pointer to NameTable structure
+ * @return true on success, false if memory ran out
+ */
+static bool name_table_unmap(NameTable *names) {
+    if (!names->mapped) {
+        return true;
+    }
+    bool ok = true;
+    NameTable copy = *names;
+    copy.chars = (char *)clone_array(names->chars, names->chars_capacity, &ok);
+    copy.offsets = (size_t *)clone_array(names->offsets, names->id_capacity * sizeof(size_t), &ok);
+    copy.owners = (BlockId *)clone_array(names->owners, names->id_capacity * sizeof(BlockId), &ok);
+    copy.requested = (size_t *)clone_array(names->requested, names->id_capacity * sizeof(size_t), &ok);
+    copy.slots = (NameId *)clone_array(names->slots, names->slot_capacity * sizeof(NameId), &ok);
+    copy.mapped = false;
+    if (!ok) {
+        name_table_destroy(&copy);
+        return false;
+    }
+    *names = copy;
+    return true;
+}
+
+/**
+ * @brief Release all storage held by the table
+ * 
+ * @param names Pointer to NameTable structure
+ */
+static void name_table_destroy(NameTable *names) {
+    if (!names->mapped) {
+        free(names->chars);
+        free(names->offsets);
+        free(names->owners);
+        free(names->requested);
+        free(names->slots);
+    }
+    memset(names, 0, sizeof(NameTable));
+}
+
+/* ============================================================================
+ * ALLOCATION STRATEGIES
+ * ============================================================================ */
+
+/**
+ * @brief First Fit allocation strategy
+ * 
+ * Allocates from the first hole large enough to satisfy the request.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param size Size to allocate
+ * @param align Alignment of the block's start (a power of two)
+ * @param name Interned name of the process requesting memory
+ * @return Pointer to allocated block, or NULL if allocation fails
+ */
+static MemoryBlock *allocate_first_fit(Allocator *alloc, size_t size, size_t align, NameId name) {
+    MemoryBlock *current = find_first_fit_hole(alloc, size, align);
+    if (current == NULL) {
+        return NULL; // No suitable hole found
+    }
+    
+    // An unaligned hole keeps the bytes skipped in front of the block
+    size_t padding = align_padding(current->start, align);
+    if (padding > 0) {
+        return carve_from_hole(alloc, current, current->start + padding, size, name);
+    }
+    
+    size_t allocated_start = current->start;
+    size_t allocated_end = allocated_start + size;
+    
+    // Update current block (shrink it)
+    if (block_size(current) == size) {
+        // Exact fit - convert entire block to allocated
+        hole_index_remove(alloc, current);
+        current->type = BLOCK_ALLOCATED;
+        current->name = name;
+        return current;
+    }
+    
+    // Create new allocated block
+    MemoryBlock *allocated = create_block(alloc, allocated_start, allocated_end, 
+                                          BLOCK_ALLOCATED, name);
+    if (allocated == NULL) {
+        return NULL;
+    }
+    
+    // Partial fit - split the block
+    size_t old_size = block_size(current);
+    current->start = allocated_end;
+    hole_index_resize(alloc, current, allocated_start, old_size);
+    
+    // Insert allocated block before current
+    link_block_before(alloc, current, allocated);
+    
+    return allocated;
+}
+
+/**
+ * @brief Best Fit allocation strategy
+ * 
+ * Allocates from the smallest hole large enough to satisfy the request.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param size Size to allocate
+ * @param align Alignment of the block's start (a power of two)
+ * @param name Interned name of the process requesting memory
+ * @return Pointer to allocated block, or NULL if allocation fails
+ */
+static MemoryBlock *allocate_best_fit(Allocator *alloc, size_t size, size_t align, NameId name) {
+    // Find the smallest suitable hole
+    MemoryBlock *best = find_best_fit_hole(alloc, size, align);
+    
+    if (best == NULL) {
+        return NULL; // No suitable hole found
+    }
+    
+    size_t padding = align_padding(best->start, align);
+    if (padding > 0) {
+        return carve_from_hole(alloc, best, best->start + padding, size, name);
+    }
+    
+    // Allocate from best block
+    size_t allocated_start = best->start;
+    size_t allocated_end = allocated_start + size;
+    
+    if (block_size(best) == size) {
+        // Exact fit
+        hole_index_remove(alloc, best);
+        best->type = BLOCK_ALLOCATED;
+        best->name = name;
+        return best;
+    } else {
+        MemoryBlock *allocated = create_block(alloc, allocated_start, allocated_end, 
+                                              BLOCK_ALLOCATED, name);
+        if (allocated == NULL) {
+            return NULL;
+        }
+        
+        // Partial fit - split the block
+        size_t old_size = block_size(best);
+        best->start = allocated_end;
+        hole_index_resize(alloc, best, allocated_start, old_size);
+        
+        // Insert allocated block
+        link_block_before(alloc, best, allocated);
+        
+        return allocated;
+    }
+}
+
+/**
+ * @brief Worst Fit allocation strategy
+ * 
+ * Allocates from the largest available hole.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param size Size to allocate
+ * @param align Alignment of the block's start (a power of two)
+ * @param name Interned name of the process requesting memory
+ * @return Pointer to allocated block, or NULL if allocation fails
+ */
+static MemoryBlock *allocate_worst_fit(Allocator *alloc, size_t size, size_t align, NameId name) {
+    // Find the largest hole
+    MemoryBlock *worst = find_worst_fit_hole(alloc, size, align);
+    
+    if (worst == NULL) {
+        return NULL; // No suitable hole found
+    }
+    
+    size_t padding = align_padding(worst->start, align);
+    if (padding > 0) {
+        return carve_from_hole(alloc, worst, worst->start + padding, size, name);
+    }
+    
+    // Allocate from worst block
+    size_t allocated_start = worst->start;
+    size_t allocated_end = allocated_start + size;
+    
+    MemoryBlock *allocated = create_block(alloc, allocated_start, allocated_end, 
+                                          BLOCK_ALLOCATED, name);
+    if (allocated == NULL) {
+        return NULL;
+    }
+    
+    // Always split for worst fit (to leave largest possible remainder)
+    size_t old_size = block_size(worst);
+    worst->start = allocated_end;
+    hole_index_resize(alloc, worst, allocated_start, old_size);
+    
+    // Insert allocated block
+    link_block_before(alloc, worst, allocated);
+    
+    return allocated;
+}
+
+/**
+ * @brief Carve an allocated block out of any part of a hole
+ * 
+ * Unlike the F/B/W splits, which always allocate from the front of a hole,
+ * the range may sit in the middle, leaving a hole on either side.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param hole Hole containing [start, start + size)
+ * @param start Start of the range to allocate
+ * @param size Size of the range to allocate
+ * @param name Interned name of the process requesting memory
+ * @return Pointer to allocated block, or NULL if a node could not be allocated
+ */
+static MemoryBlock *carve_from_hole(Allocator *alloc, MemoryBlock *hole, size_t start, size_t size, NameId name) {
+    size_t end = start + size;
+    
+    if (start == hole->start && end == hole->end) {
+        // Exact fit - convert entire block to allocated
+        hole_index_remove(alloc, hole);
+        hole->type = BLOCK_ALLOCATED;
+        hole->name = name;
+        return hole;
+    }
+    
+    MemoryBlock *allocated = create_block(alloc, start, end, BLOCK_ALLOCATED, name);
+    if (allocated == NULL) {
+        return NULL;
+    }
+    
+    if (start == hole->start) {
+        // Allocate from the front, like First Fit
+        hole->start = end;
+        hole_index_resize(alloc, hole, start, hole->end - start);
+        link_block_before(alloc, hole, allocated);
+        return allocated;
+    }
+    
+    MemoryBlock *tail = NULL;
+    if (end < hole->end) {
+        tail = create_block(alloc, end, hole->end, BLOCK_FREE, NO_NAME);
+        if (tail == NULL) {
+            free_block(alloc, allocated);
+            return NULL;
+        }
+    }
+    
+    // Keep the front of the hole and put the rest behind the allocation
+    size_t old_size = block_size(hole);
+    hole->end = start;
+    hole_index_resize(alloc, hole, hole->start, old_size);
+    link_block_after(alloc, hole, allocated);
+    if (tail != NULL) {
+        link_block_after(alloc, allocated, tail);
+        hole_index_insert(alloc, tail);
+    }
+    return allocated;
+}
+
+/**
+ * @brief Buddy allocation strategy
+ * 
+ * Rounds the request up to a power of two and takes a free buddy chunk of
+ * the smallest sufficient order, splitting it down to the requested order.
+ * The split buddies stay behind as the remaining pieces of the hole, and
+ * they merge back when the hole coalesces on release. Every chunk starts
+ * on a multiple of its own size, so an alignment larger than the request
+ * is met by allocating a chunk of the alignment's size.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param size Size to allocate
+ * @param align Alignment of the block's start (a power of two)
+ * @param name Interned name of the process requesting memory
+ * @return Pointer to allocated block, or NULL if allocation fails
+ */
+static MemoryBlock *allocate_buddy(Allocator *alloc, size_t size, size_t align, NameId name) {
+    if (!alloc->buddy.active && !buddy_index_build(alloc)) {
+        return NULL;
+    }
+    
+    int order = buddy_order((size > align) ? size : align);
+    if (order >= SIZE_CLASS_COUNT) {
+        return NULL;
+    }
+    uint64_t candidates = alloc->buddy.order_map & (~0ULL << order);
+    if (candidates == 0) {
+        return NULL; // No chunk large enough
+    }
+    
+    BuddyChunk *chunk = &alloc->buddy.chunks[alloc->buddy.free_lists[__builtin_ctzll(candidates)] - 1];
+    alloc->probes++;
+    return carve_from_hole(alloc, block_at(alloc, chunk->hole), chunk->start, (size_t)1 << order, name);
+}
+
+/**
+ * @brief TLSF allocation strategy
+ * 
+ * Takes the head of the first non-empty list whose holes are all large
+ * enough, found through the two bitmaps, and allocates from its front.
+ * An aligned request looks for size + align - 1 bytes, as TLSF's own
+ * aligned allocation does, so the head found always has room for the
+ * padding and the lookup stays constant time.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param size Size to allocate
+ * @param align Alignment of the block's start (a power of two)
+ * @param name Interned name of the process requesting memory
+ * @return Pointer to allocated block, or NULL if allocation fails
+ */
+static MemoryBlock *allocate_tlsf(Allocator *alloc, size_t size, size_t align, NameId name) {
+    if (!alloc->tlsf.active && !tlsf_index_build(alloc)) {
+        return NULL;
+    }
+    
+    MemoryBlock *hole = tlsf_find(alloc, padded_size(size, align));
+    if (hole == NULL) {
+        return NULL; // No suitable hole found
+    }
+    return carve_from_hole(alloc, hole, hole->start + align_padding(hole->start, align), size, name);
+}
+
+/**
+ * @brief Next Fit allocation strategy
+ * 
+ * Walks the block list from the rover, wrapping round to the head, and
+ * allocates from the front of the first hole that fits. The rover is then
+ * left on the block after the allocation, so the next search resumes
+ * where this one stopped instead of rescanning the small holes that
+ * earlier requests left near the start of memory.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param size Size to allocate
+ * @param align Alignment of the block's start (a power of two)
+ * @param name Interned name of the process requesting memory
+ * @return Pointer to allocated block, or NULL if allocation fails
+ */
+static MemoryBlock *allocate_next_fit(Allocator *alloc, size_t size, size_t align, NameId name) {
+    MemoryBlock *start = block_at(alloc, alloc->rover);
+    if (start == NULL) {
+        start = first_block(alloc);
+    }
+    
+    MemoryBlock *current = start;
+    do {
+        alloc->probes++;
+        if (current->type == BLOCK_FREE && hole_fits(current, size, align)) {
+            MemoryBlock *allocated = carve_from_hole(alloc, current, current->start + align_padding(current->start, align),
+                                                     size, name);
+            if (allocated != NULL) {
+                alloc->rover = allocated->next;
+            }
+            return allocated;
+        }
+        current = next_block(alloc, current);
+        if (current == NULL) {
+            current = first_block(alloc);
+        }
+    } while (current != start);
+    
+    return NULL; // No suitable hole found
+}
+
+/**
+ * @brief Size a request is allocated as once rounded up to its size class
+ * 
+ * The classes are searched by bisection. A request above the largest
+ * class is rounded up to a multiple of it.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param size Requested size
+ * @return Rounded size (size itself without size classes, SIZE_MAX on overflow)
+ */
+static size_t round_to_size_class(const Allocator *alloc, size_t size) {
+    size_t count = alloc->size_class_count;
+    if (count == 0) {
+        return size;
+    }
+    
+    size_t largest = alloc->size_classes[count - 1];
+    if (size > largest) {
+        size_t shortfall = (largest - size % largest) % largest;
+        return (size <= SIZE_MAX - shortfall) ? size + shortfall : SIZE_MAX;
+    }
+    
+    size_t low = 0;
+    size_t high = count - 1;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (alloc->size_classes[mid] >= size) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return alloc->size_classes[low];
+}
+
+/**
+ * @brief Largest request that is no larger than size once rounded up to its size class
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param size Room available
+ * @return The largest class, or multiple of the largest class, that fits (size itself without size classes)
+ */
+static size_t size_class_floor(const Allocator *alloc, size_t size) {
+    size_t count = alloc->size_class_count;
+    if (count == 0) {
+        return size;
+    }
+    
+    size_t largest = alloc->size_classes[count - 1];
+    if (size >= largest) {
+        return size - size % largest;
+    }
+    
+    size_t low = 0;
+    size_t high = count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (alloc->size_classes[mid] <= size) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return (low > 0) ? alloc->size_classes[low - 1] : 0;
+}
+
+/**
+ * @brief Largest block the given strategy could allocate now on a multiple of align
+ * 
+ * Every figure comes from the indexes, not from the block list (except
+ * with --index=list): F, B and N can use the hole that holds the largest
+ * aligned block, W only the largest hole, Buddy the largest free chunk,
+ * and TLSF any size up to the lowest size of its highest non-empty list,
+ * less the padding it searches for.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param align Alignment of the block's start (a power of two)
+ * @param strategy Allocation strategy
+ * @return Size in bytes; a request fits if, rounded to its size class, it is no larger
+ */
+static size_t largest_request(Allocator *alloc, size_t align, AllocationStrategy strategy) {
+    switch (strategy) {
+        case STRATEGY_WORST_FIT: {
+            MemoryBlock *worst = find_worst_fit_hole(alloc, 1, 1);
+            size_t padding = (worst != NULL) ? align_padding(worst->start, align) : 0;
+            return (worst != NULL && block_size(worst) > padding) ? block_size(worst) - padding : 0;
+        }
+        case STRATEGY_BUDDY: {
+            if ((!alloc->buddy.active && !buddy_index_build(alloc)) || alloc->buddy.order_map == 0) {
+                return 0;
+            }
+            size_t chunk = (size_t)1 << (63 - __builtin_clzll(alloc->buddy.order_map));
+            return (chunk >= align) ? chunk : 0;
+        }
+        case STRATEGY_TLSF: {
+            if ((!alloc->tlsf.active && !tlsf_index_build(alloc)) || alloc->tlsf.fl_map == 0) {
+                return 0;
+            }
+            int fl = 63 - __builtin_clzll(alloc->tlsf.fl_map);
+            int sl = 31 - __builtin_clz(alloc->tlsf.sl_map[fl]);
+            size_t lowest = (fl == 0) ? (size_t)sl : (size_t)(sl + TLSF_SL_COUNT) << (fl - 1);
+            return (lowest >= align - 1) ? lowest - (align - 1) : 0;
+        }
+        default:
+            return largest_aligned_block(alloc, align);
+    }
+}
+
+/**
+ * @brief Allocate memory using the specified strategy
+ * 
+ * The request is first rounded up to its size class, and the strategy
+ * then places a block of that size on a multiple of align. The blocks or
+ * index entries each strategy examines are counted, so STAT can report
+ * the average probe length of its searches.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param size Size requested
+ * @param align Alignment of the block's start (a power of two)
+ * @param name Interned name of the process requesting memory
+ * @param strategy Allocation strategy to use
+ * @return Pointer to allocated block, or NULL if allocation fails
+ */
+static MemoryBlock *allocate_memory(Allocator *alloc, size_t size, size_t align, NameId name,
+                                    AllocationStrategy strategy) {
+    size_t rounded = round_to_size_class(alloc, size);
+    MemoryBlock *block;
+    alloc->probes = 0;
+    switch (strategy) {
+        case STRATEGY_FIRST_FIT:
+            block = allocate_first_fit(alloc, rounded, align, name);
+            break;
+        case STRATEGY_BEST_FIT:
+            block = allocate_best_fit(alloc, rounded, align, name);
+            break;
+        case STRATEGY_WORST_FIT:
+            block = allocate_worst_fit(alloc, rounded, align, name);
+            break;
+        case STRATEGY_BUDDY:
+            block = allocate_buddy(alloc, rounded, align, name);
+            break;
+        case STRATEGY_TLSF:
+            block = allocate_tlsf(alloc, rounded, align, name);
+            break;
+        case STRATEGY_NEXT_FIT:
+            block = allocate_next_fit(alloc, rounded, align, name);
+            break;
+        default:
+            return NULL;
+    }
+    alloc->searches[strategy]++;
+    alloc->search_probes[strategy] += alloc->probes;
+    
+    if (block != NULL) {
+        address_index_add(alloc, block);
+        block->align_log2 = (uint8_t)__builtin_ctzll((unsigned long long)align);
+        alloc->align_reserve += align_reserve(alloc, block);
+        alloc->names.owners[name] = block->id;
+        alloc->names.requested[name] = size;
+        alloc->internal_waste += block_size(block) - size;
+        alloc->rounding_waste += rounded - size;
+    }
+    return block;
+}
+
+/* ============================================================================
+ * MEMORY OPERATIONS
+ * ============================================================================ */
+
+/**
+ * @brief Release memory allocated to a process
+ * 
+ * Converts the allocated block to a free block and merges it with its
+ * neighbouring holes in constant time.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param name Interned name of the process whose memory should be released
+ * @return 0 on success, -1 if process not found
+ */
+static int release_memory(Allocator *alloc, NameId name) {
+    MemoryBlock *current = block_at(alloc, alloc->names.owners[name]);
+    if (current == NULL) {
+        return -1; // Process not found
+    }
+    
+    // Found the process - convert to free block
+    address_index_drop(alloc, current);
+    alloc->names.owners[current->name] = NIL_BLOCK;
+    size_t requested = alloc->names.requested[current->name];
+    alloc->internal_waste -= block_size(current) - requested;
+    alloc->rounding_waste -= round_to_size_class(alloc, requested) - requested;
+    alloc->align_reserve -= align_reserve(alloc, current);
+    current->type = BLOCK_FREE;
+    current->name = NO_NAME;
+    alloc->process_count--;
+    
+    // Merge adjacent holes
+    merge_adjacent_holes(alloc, current);
+    
+    return 0;
+}
+
+/**
+ * @brief Change the size of the block a process holds
+ * 
+ * Shrinking hands the tail of the block to the following hole, or makes
+ * it a new hole. Growing takes the front of the following hole when that
+ * is large enough. Otherwise a new block is allocated with the given
+ * strategy while the old one is still held, since its contents have to
+ * be copied over, and only then is the old block released. Either way
+ * the block ends up new_size bytes rounded up to its size class, and it
+ * keeps the alignment it was first requested with.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param name Interned name of a process that holds memory
+ * @param new_size New size of its block (non-zero)
+ * @param strategy Strategy to allocate the new block with if it has to move
+ * @param relocated Output: whether the block moved
+ * @return The block now held, or NULL if there was no room (the old block is kept)
+ */
+static MemoryBlock *resize_memory(Allocator *alloc, NameId name, size_t new_size, AllocationStrategy strategy,
+                                  bool *relocated) {
+    MemoryBlock *block = block_at(alloc, alloc->names.owners[name]);
+    size_t old_size = block_size(block);
+    size_t old_requested = alloc->names.requested[name];
+    size_t old_waste = old_size - old_requested;
+    size_t old_rounding = round_to_size_class(alloc, old_requested) - old_requested;
+    size_t new_block_size = round_to_size_class(alloc, new_size);
+    MemoryBlock *next = next_block(alloc, block);
+    bool next_free = next != NULL && next->type == BLOCK_FREE && next->start == block->end;
+    *relocated = false;
+    
+    if (new_block_size < old_size) {
+        // Shrink in place, giving the tail back
+        size_t new_end = block->start + new_block_size;
+        if (next_free) {
+            size_t hole_size = block_size(next);
+            next->start = new_end;
+            hole_index_resize(alloc, next, block->end, hole_size);
+        } else {
+            MemoryBlock *tail = create_block(alloc, new_end, block->end, BLOCK_FREE, NO_NAME);
+            if (tail == NULL) {
+                return NULL;
+            }
+            link_block_after(alloc, block, tail);
+            hole_index_insert(alloc, tail);
+        }
+        block->end = new_end;
+    } else if (new_block_size > old_size && next_free && block_size(next) >= new_block_size - old_size) {
+        // Grow in place into the following hole
+        size_t extra = new_block_size - old_size;
+        if (block_size(next) == extra) {
+            hole_index_remove(alloc, next);
+            unlink_block(alloc, next);
+            free_block(alloc, next);
+        } else {
+            size_t hole_size = block_size(next);
+            next->start += extra;
+            hole_index_resize(alloc, next, block->end, hole_size);
+        }
+        block->end += extra;
+    } else if (new_block_size > old_size) {
+        // Relocate: the new block takes over the name, then the old one is freed
+        MemoryBlock *moved = allocate_memory(alloc, new_size, (size_t)1 << block->align_log2, name, strategy);
+        if (moved == NULL) {
+            return NULL;
+        }
+        alloc->internal_waste -= old_waste;
+        alloc->rounding_waste -= old_rounding;
+        alloc->align_reserve -= align_reserve(alloc, block);
+        address_index_drop(alloc, block);
+        block->type = BLOCK_FREE;
+        block->name = NO_NAME;
+        merge_adjacent_holes(alloc, block);
+        *relocated = true;
+        return moved;
+    }
     
-    // Find the smallest suitable hole
-    while (current != NULL) {
-        if (current->type == BLOCK_FREE && current->size >= size) {
-            if (current->size < best_size) {
-                best = current;
-                best_size = current->size;
+    alloc->internal_waste -= old_waste;
+    alloc->internal_waste += new_block_size - new_size;
+    alloc->rounding_waste -= old_rounding;
+    alloc->rounding_waste += new_block_size - new_size;
+    alloc->names.requested[name] = new_size;
+    return block;
+}
+
+/**
+ * @brief Slide the allocated blocks of a run of the list down over its holes
+ * 
+ * Walks from `from` up to (not including) `stop`, moving each allocated
+ * block down to the end of the previous one and unlinking the holes it
+ * passes. The first of those holes is reused for the gathered free space,
+ * so no nodes are allocated.
+ * 
+ * With a budget, sliding stops before the first block whose move would
+ * take the total past max_bytes_moved. The free space gathered so far then
+ * becomes one hole in front of that block, and the rest is left as it was.
+ * 
+ * A block requested with an alignment only slides down to the next
+ * multiple of it, and the padding in front of it is left as a hole.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param from First block of the run
+ * @param stop Block after the run, or NULL to run to the end of memory
+ * @param max_bytes_moved Most bytes of allocated blocks to move (SIZE_MAX for no limit)
+ * @return Number of bytes moved
+ */
+static size_t slide_blocks(Allocator *alloc, MemoryBlock *from, MemoryBlock *stop, size_t max_bytes_moved) {
+    size_t next_start = from->start;
+    size_t moved = 0;
+    MemoryBlock *gap = NULL;                     // First hole passed, reused for the free space
+    MemoryBlock *tail = prev_block(alloc, from); // Last block already in place
+    
+    MemoryBlock *current = from;
+    while (current != stop) {
+        MemoryBlock *next = next_block(alloc, current);
+        
+        if (current->type == BLOCK_FREE) {
+            hole_index_remove(alloc, current);
+            unlink_block(alloc, current);
+            if (gap == NULL) {
+                gap = current;
+            } else {
+                free_block(alloc, current);
+            }
+        } else {
+            size_t target = next_start + align_padding(next_start, (size_t)1 << current->align_log2);
+            if (current->start != target && block_size(current) > max_bytes_moved - moved) {
+                break; // Budget exhausted
             }
+            if (target != next_start) {
+                // Leave the alignment padding in front of the block
+                MemoryBlock *padding = gap;
+                if (current->start == target) {
+                    gap = NULL; // The padding is all the space gathered
+                } else if ((padding = create_block(alloc, next_start, target, BLOCK_FREE, NO_NAME)) == NULL) {
+                    break; // Out of nodes: stop here, as if the budget ran out
+                }
+                padding->start = next_start;
+                padding->end = target;
+                link_block_before(alloc, current, padding);
+                merge_adjacent_holes(alloc, padding);
+                next_start = target;
+            }
+            if (current->start != next_start) {
+                size_t size = block_size(current);
+                current->start = next_start;
+                current->end = next_start + size;
+                moved += size;
+            }
+            next_start = current->end;
+            tail = current;
         }
-        current = current->next;
+        current = next;
     }
     
-    if (best == NULL) {
-        return NULL; // No suitable hole found
+    if (gap == NULL) {
+        return moved; // No holes in the run
     }
     
-    // Allocate from best block
-    size_t allocated_start = best->start;
-    size_t allocated_end = allocated_start + size;
+    // Everything between the slid blocks and the first unmoved block is free
+    size_t gap_end = (current != NULL) ? current->start : alloc->total_size;
+    if (gap_end == next_start) {
+        free_block(alloc, gap);
+        return moved;
+    }
     
-    if (best->size == size) {
-        // Exact fit
-        best->type = BLOCK_ALLOCATED;
-        strncpy(best->process_name, process_name, MAX_PROCESS_NAME_LENGTH - 1);
-        best->process_name[MAX_PROCESS_NAME_LENGTH - 1] = '\0';
-        return best;
+    gap->start = next_start;
+    gap->end = gap_end;
+    if (current != NULL) {
+        link_block_before(alloc, current, gap);
+    } else if (tail != NULL) {
+        link_block_after(alloc, tail, gap);
     } else {
-        // Partial fit - split the block
-        best->start = allocated_end;
-        best->size = best->end - best->start;
+        alloc->blocks = gap->id;
+    }
+    
+    // Next Fit resumes at the free space just gathered
+    alloc->rover = merge_adjacent_holes(alloc, gap)->id;
+    return moved;
+}
+
+/**
+ * @brief Compact memory by sliding allocated blocks towards address 0
+ * 
+ * All free blocks are merged into one large block at the end, in a single
+ * pass over the list. With a budget only a prefix of memory is compacted.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param max_bytes_moved Most bytes of allocated blocks to move (SIZE_MAX for no limit)
+ * @return Number of bytes moved
+ */
+static size_t compact_memory(Allocator *alloc, size_t max_bytes_moved) {
+    return slide_blocks(alloc, first_block(alloc), NULL, max_bytes_moved);
+}
+
+/**
+ * @brief Smallest hole that the given strategy is guaranteed to allocate from
+ * 
+ * F/B/W can use any hole of the requested size. TLSF only looks at lists
+ * above the request's own second-level range, and a buddy block of 2^k
+ * bytes must be aligned, which any hole of 2^(k+1) - 1 bytes allows. An
+ * aligned request needs room for its worst-case padding as well, and
+ * Buddy a chunk of at least the alignment.
+ * 
+ * @param size Requested size
+ * @param align Alignment of the block's start (a power of two)
+ * @param strategy Allocation strategy
+ * @return Required hole size, or SIZE_MAX if no hole can be large enough
+ */
+static size_t compaction_target(size_t size, size_t align, AllocationStrategy strategy) {
+    if (strategy == STRATEGY_BUDDY) {
+        int order = buddy_order((size > align) ? size : align);
+        return (order < SIZE_CLASS_COUNT - 1) ? ((size_t)2 << order) - 1 : SIZE_MAX;
+    }
+    size = padded_size(size, align);
+    if (strategy == STRATEGY_TLSF && size >= TLSF_SL_COUNT) {
+        int log2 = 63 - __builtin_clzll((unsigned long long)size);
+        size_t round = ((size_t)1 << (log2 - TLSF_SL_LOG2)) - 1;
+        return (size <= SIZE_MAX - round) ? size + round : SIZE_MAX;
+    }
+    return size;
+}
+
+/**
+ * @brief Find the cheapest window of blocks that sliding together leaves a hole of the needed size
+ * 
+ * A two-pointer scan over the block list looks for runs of consecutive
+ * blocks whose holes add up to the required size plus the align_reserve()
+ * of each allocated block in the run, since the slide may leave that much
+ * padding behind. Any run found is therefore sure to yield the hole. Of
+ * the runs the scan meets, the one holding the fewest allocated bytes,
+ * which are the bytes sliding it moves, is kept. A window is always found
+ * when the whole memory qualifies, that is when total_free is at least
+ * needed plus the allocator's align_reserve.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param needed Size of the hole the window must yield
+ * @param first Output: first block of the window
+ * @param last Output: last block of the window
+ * @param cost Output: allocated bytes in the window
+ * @return true if a window was found, false if no run of blocks qualifies
+ */
+static bool find_compaction_window(Allocator *alloc, size_t needed, MemoryBlock **first, MemoryBlock **last,
+                                   size_t *cost) {
+    if (needed > alloc->total_free) {
+        return false;
+    }
+    
+    MemoryBlock *best_first = NULL;
+    MemoryBlock *best_last = NULL;
+    size_t best_cost = SIZE_MAX;
+    
+    MemoryBlock *left = first_block(alloc);
+    size_t window_free = 0;
+    size_t window_cost = 0;
+    size_t window_reserve = 0;
+    size_t window_blocks = 0;
+    
+    for (MemoryBlock *right = left; right != NULL; right = next_block(alloc, right)) {
+        if (right->type == BLOCK_FREE) {
+            window_free += block_size(right);
+        } else {
+            window_cost += block_size(right);
+            window_reserve += align_reserve(alloc, right);
+        }
+        window_blocks++;
         
-        MemoryBlock *allocated = create_block(allocated_start, allocated_end, 
-                                              BLOCK_ALLOCATED, process_name);
-        if (allocated == NULL) {
-            best->start = allocated_start;
-            best->size = best->end - best->start;
-            return NULL;
+        // Drop leading blocks that only add cost
+        while (window_blocks > 0) {
+            if (left->type == BLOCK_ALLOCATED) {
+                window_cost -= block_size(left);
+                window_reserve -= align_reserve(alloc, left);
+            } else if (window_free - block_size(left) >= needed &&
+                       window_free - block_size(left) - needed >= window_reserve) {
+                window_free -= block_size(left);
+            } else {
+                break;
+            }
+            left = next_block(alloc, left);
+            window_blocks--;
         }
         
-        // Insert allocated block
-        if (alloc->blocks == best) {
-            allocated->next = best;
-            alloc->blocks = allocated;
+        if (window_blocks > 0 && window_free >= needed && window_free - needed >= window_reserve &&
+            window_cost < best_cost) {
+            best_first = left;
+            best_last = right;
+            best_cost = window_cost;
+        }
+    }
+    
+    if (best_first == NULL) {
+        return false;
+    }
+    *first = best_first;
+    *last = best_last;
+    *cost = best_cost;
+    return true;
+}
+
+/**
+ * @brief Open a hole for a failed request by sliding the cheapest window
+ * 
+ * Only the allocated blocks in the window found by find_compaction_window()
+ * are moved; the rest of memory is untouched.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param size Size of the block to allocate, rounded up to its size class
+ * @param align Alignment of the block's start (a power of two)
+ * @param strategy Strategy the request will be retried with
+ * @param moved Output: number of bytes moved
+ * @return true if a window was compacted, false if no window is sure to make room
+ */
+static bool compact_for_request(Allocator *alloc, size_t size, size_t align, AllocationStrategy strategy,
+                                size_t *moved) {
+    MemoryBlock *first, *last;
+    size_t cost;
+    if (!find_compaction_window(alloc, compaction_target(size, align, strategy), &first, &last, &cost)) {
+        return false;
+    }
+    *moved = slide_blocks(alloc, first, next_block(alloc, last), SIZE_MAX);
+    return true;
+}
+
+/* ============================================================================
+ * STATISTICS AND REPORTING
+ * ============================================================================ */
+
+/**
+ * @brief Calculate fragmentation metrics
+ * 
+ * Reads the totals kept by the hole index hooks, so it does not walk the
+ * block list.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param total_allocated Output: total allocated memory
+ * @param total_free Output: total free memory
+ * @param largest_hole Output: size of largest free block
+ * @param hole_count Output: number of free blocks
+ * @param external_frag Output: external fragmentation percentage
+ * @param avg_hole_size Output: average hole size
+ * @param internal_frag Output: bytes allocated beyond requests, as a percentage of those allocated
+ * @param rounding_frag Output: the part of internal_frag due to size-class rounding
+ */
+static void calculate_fragmentation(Allocator *alloc, size_t *total_allocated, size_t *total_free, 
+                                    size_t *largest_hole, size_t *hole_count,
+                                    double *external_frag, double *avg_hole_size,
+                                    double *internal_frag, double *rounding_frag) {
+    *total_free = alloc->total_free;
+    *total_allocated = alloc->total_size - alloc->total_free;
+    *largest_hole = largest_hole_size(alloc);
+    *hole_count = alloc->hole_count;
+    
+    // Calculate external fragmentation: (1 - largest_free_block / total_free) * 100
+    if (*total_free > 0) {
+        *external_frag = (1.0 - (double)(*largest_hole) / (double)(*total_free)) * 100.0;
+    } else {
+        *external_frag = 0.0;
+    }
+    
+    // Calculate average hole size
+    if (*hole_count > 0) {
+        *avg_hole_size = (double)(*total_free) / (double)(*hole_count);
+    } else {
+        *avg_hole_size = 0.0;
+    }
+    
+    // Internal fragmentation, and the share of it size classes account for
+    if (*total_allocated > 0) {
+        *internal_frag = (double)alloc->internal_waste * 100.0 / (double)(*total_allocated);
+        *rounding_frag = (double)alloc->rounding_waste * 100.0 / (double)(*total_allocated);
+    } else {
+        *internal_frag = 0.0;
+        *rounding_frag = 0.0;
+    }
+}
+
+/**
+ * @brief Print the memory map of [from, to) in width columns
+ * 
+ * Each column shows '#' if its range is wholly allocated, '.' if it is
+ * wholly free and '+' if it is mixed. Columns are answered by the
+ * occupancy tree, so the map takes O(width log n) at any zoom level once
+ * the tree has been built.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param out Stream to write to
+ * @param width Number of columns (at most to - from)
+ * @param from Start of the range shown
+ * @param to End of the range shown
+ */
+static void print_visualization(Allocator *alloc, FILE *out, size_t width, size_t from, size_t to) {
+    if (!alloc->occupancy.active && !occupancy_build(alloc)) {
+        fprintf(out, "Memory map: not enough memory to build the occupancy tree\n");
+        return;
+    }
+    
+    const OccupancyTree *tree = &alloc->occupancy;
+    size_t span = to - from;
+    size_t root_end = tree->leaf_count * tree->leaf_size;
+    fprintf(out, "[");
+    for (size_t i = 0; i < width; i++) {
+        // Column i covers [from + span * i / width, from + span * (i + 1) / width)
+        size_t lo = from + (span / width) * i + (span % width) * i / width;
+        size_t hi = from + (span / width) * (i + 1) + (span % width) * (i + 1) / width;
+        int64_t free_bytes = occupancy_free_bytes(alloc, 1, 0, root_end, lo, hi, 0);
+        if (free_bytes <= 0) {
+            putc('#', out);
+        } else if ((size_t)free_bytes >= hi - lo) {
+            putc('.', out);
         } else {
-            MemoryBlock *prev = alloc->blocks;
-            while (prev->next != best) {
-                prev = prev->next;
+            putc('+', out);
+        }
+    }
+    fprintf(out, "]\n");
+    
+    int label = fprintf(out, "^%zu", from);
+    for (size_t i = (label > 0) ? (size_t)label : 0; i < width; i++) {
+        putc(' ', out);
+    }
+    fprintf(out, "^%zu\n", to);
+    if (tree->leaf_size > 1 && span / width < tree->leaf_size) {
+        fprintf(out, "(columns narrower than %zu bytes are estimated)\n", tree->leaf_size);
+    }
+}
+
+/**
+ * @brief Print the occupancy of the TLSF first- and second-level bitmaps
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param out Stream to write to
+ */
+static void print_tlsf_bitmaps(const Allocator *alloc, FILE *out) {
+    const TlsfIndex *tlsf = &alloc->tlsf;
+    if (!tlsf->active) {
+        fprintf(out, "TLSF bitmaps: not built (no T requests yet)\n");
+        return;
+    }
+    
+    fprintf(out, "TLSF bitmaps:\n");
+    fprintf(out, "First level: 0x%016llx (%d of %d ranges non-empty)\n",
+            (unsigned long long)tlsf->fl_map, __builtin_popcountll(tlsf->fl_map), TLSF_FL_COUNT);
+    
+    for (int fl = 0; fl < TLSF_FL_COUNT; fl++) {
+        if (tlsf->sl_map[fl] == 0) {
+            continue;
+        }
+        
+        char bits[TLSF_SL_COUNT + 1];
+        for (int sl = 0; sl < TLSF_SL_COUNT; sl++) {
+            bits[TLSF_SL_COUNT - 1 - sl] = (tlsf->sl_map[fl] & (1u << sl)) ? '1' : '0';
+        }
+        bits[TLSF_SL_COUNT] = '\0';
+        
+        size_t holes = 0;
+        for (int sl = 0; sl < TLSF_SL_COUNT; sl++) {
+            for (BlockId id = tlsf->heads[fl][sl]; id != NIL_BLOCK; id = tlsf->next[id]) {
+                holes++;
             }
-            prev->next = allocated;
-            allocated->next = best;
         }
         
-        return allocated;
+        size_t low = (fl == 0) ? 0 : (size_t)1 << (fl + TLSF_SL_LOG2 - 1);
+        size_t high = (fl == 0) ? TLSF_SL_COUNT - 1 : low * 2 - 1;
+        fprintf(out, "FL %2d [%zu-%zu bytes]: SL %s, %zu hole%s\n",
+                fl, low, high, bits, holes, holes == 1 ? "" : "s");
+    }
+}
+
+/**
+ * @brief Print the allocated blocks and holes overlapping [from, to), in address order
+ * 
+ * Listing the whole memory walks the list from its head. A range that
+ * starts further in is found through the address index, so the cost
+ * depends on the blocks listed and not on where they lie. Each line
+ * gives its start, end and size in the one unit that divides all three.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param out Stream to write to
+ * @param from Start of the range (0 for the whole memory)
+ * @param to End of the range, at most the memory size
+ */
+static void print_block_listing(Allocator *alloc, FILE *out, size_t from, size_t to) {
+    char start_text[SIZE_TEXT_LENGTH], end_text[SIZE_TEXT_LENGTH], size_text[SIZE_TEXT_LENGTH];
+    MemoryBlock *first = (from == 0) ? first_block(alloc) : address_index_find(alloc, from);
+    const char *scope = (from == 0 && to == alloc->total_size) ? "" : " in range";
+    
+    // Print allocated memory
+    fprintf(out, "Allocated memory:\n");
+    size_t allocated_count = 0;
+    for (MemoryBlock *current = first; current != NULL && current->start < to; current = next_block(alloc, current)) {
+        if (current->type == BLOCK_ALLOCATED) {
+            int unit = size_unit(current->start | current->end);
+            fprintf(out, "Process %s: Start = %s, End = %s, Size = %s\n",
+                    block_name(alloc, current),
+                    format_size_in(current->start, unit, start_text),
+                    format_size_in(current->end, unit, end_text),
+                    format_size_in(block_size(current), unit, size_text));
+            allocated_count++;
+        }
+    }
+    if (allocated_count == 0) {
+        fprintf(out, "(No allocated memory%s)\n", scope);
+    }
+    
+    // Print free memory
+    fprintf(out, "Free memory:\n");
+    size_t hole_num = 1;
+    for (MemoryBlock *current = first; current != NULL && current->start < to; current = next_block(alloc, current)) {
+        if (current->type == BLOCK_FREE) {
+            int unit = size_unit(current->start | current->end);
+            fprintf(out, "Hole %zu: Start = %s, End = %s, Size = %s\n",
+                    hole_num++,
+                    format_size_in(current->start, unit, start_text),
+                    format_size_in(current->end, unit, end_text),
+                    format_size_in(block_size(current), unit, size_text));
+        }
+    }
+    if (hole_num == 1) {
+        fprintf(out, "(No free memory%s)\n", scope);
+    }
+}
+
+/**
+ * @brief Print the average probe length of each strategy used so far
+ * 
+ * A probe is one block or index entry a search looks at, so list scans
+ * count every block passed and the indexes count the nodes or list heads
+ * they visit.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param out Stream to write to
+ */
+static void print_probe_lengths(const Allocator *alloc, FILE *out) {
+    static const char letters[ALLOCATOR_STRATEGY_COUNT] = {'F', 'B', 'W', 'Y', 'T', 'N'};
+    
+    fprintf(out, "Average probe length:");
+    bool any = false;
+    for (int strategy = 0; strategy < ALLOCATOR_STRATEGY_COUNT; strategy++) {
+        if (alloc->searches[strategy] == 0) {
+            continue;
+        }
+        fprintf(out, "%s %c %.1f (%zu search%s)", any ? "," : "", letters[strategy],
+                (double)alloc->search_probes[strategy] / (double)alloc->searches[strategy],
+                alloc->searches[strategy], alloc->searches[strategy] == 1 ? "" : "es");
+        any = true;
+    }
+    fprintf(out, "%s\n", any ? "" : " no searches yet");
+}
+
+/**
+ * @brief Print statistics report
+ * 
+ * The summary comes from the totals kept on every operation, so with
+ * ALLOCATOR_STAT_SUMMARY the report takes constant time; the block listing
+ * and the memory map walk the list.
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param out Stream to write to
+ * @param flags ALLOCATOR_STAT_* flags selecting the parts to print
+ */
+void allocator_print_statistics(Allocator *alloc, FILE *out, unsigned flags) {
+    if ((flags & ALLOCATOR_STAT_SUMMARY) == 0) {
+        print_block_listing(alloc, out, 0, alloc->total_size);
     }
+    
+    // Calculate and print summary
+    size_t total_allocated, total_free, largest_hole, hole_count;
+    double external_frag, avg_hole_size, internal_frag, rounding_frag;
+    
+    calculate_fragmentation(alloc, &total_allocated, &total_free, &largest_hole, &hole_count,
+                          &external_frag, &avg_hole_size, &internal_frag, &rounding_frag);
+    
+    char text[SIZE_TEXT_LENGTH];
+    fprintf(out, "Summary:\n");
+    fprintf(out, "Total allocated: %s\n", format_size(total_allocated, text));
+    fprintf(out, "Total free: %s\n", format_size(total_free, text));
+    fprintf(out, "Largest hole: %s\n", format_size(largest_hole, text));
+    fprintf(out, "External fragmentation: %.1f%% (1-largest free block/total free memory)\n", external_frag);
+    fprintf(out, "Average hole size: %s\n", format_size((size_t)(avg_hole_size + 0.5), text));
+    fprintf(out, "Internal fragmentation: %.1f%% (%zu bytes allocated beyond requests/total allocated)\n",
+            internal_frag, alloc->internal_waste);
+    if (alloc->size_class_count > 0) {
+        fprintf(out, "Size-class rounding: %.1f%% (%zu of those bytes/total allocated)\n",
+                rounding_frag, alloc->rounding_waste);
+    }
+    fprintf(out, "Block pool: %zu slab%s, %zu nodes in use, high-water mark %zu nodes\n",
+            alloc->pool.slab_count, alloc->pool.slab_count == 1 ? "" : "s",
+            alloc->pool.live_nodes, alloc->pool.high_water);
+    print_probe_lengths(alloc, out);
+    fprintf(out, "Resizes: %zu in place, %zu relocated (%zu bytes copied), %zu failed\n",
+            alloc->resize_in_place_count, alloc->resize_relocated_count, alloc->resize_bytes_copied,
+            alloc->failed_resize_count);
+    
+    if (flags & ALLOCATOR_STAT_TLSF) {
+        print_tlsf_bitmaps(alloc, out);
+    }
+    
+    // Print visualization if requested
+    if (flags & ALLOCATOR_STAT_VISUALIZE) {
+        fprintf(out, "\n");
+        print_visualization(alloc, out, ALLOCATOR_MAP_WIDTH, 0, alloc->total_size);
+    }
+}
+
+/**
+ * @brief Print the allocated blocks and holes overlapping part of the memory
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param out Stream to write to
+ * @param from Start of the range to list
+ * @param to End of the range to list (clipped to the memory size)
+ */
+void allocator_print_blocks(Allocator *alloc, FILE *out, size_t from, size_t to) {
+    if (to > alloc->total_size) {
+        to = alloc->total_size;
+    }
+    if (from >= to) {
+        from = 0;
+        to = alloc->total_size;
+    }
+    print_block_listing(alloc, out, from, to);
+}
+
+/**
+ * @brief Print the memory map of part of the memory
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param out Stream to write to
+ * @param width Number of columns (0 for ALLOCATOR_MAP_WIDTH)
+ * @param from Start of the range to show
+ * @param to End of the range to show (clipped to the memory size)
+ */
+void allocator_print_map(Allocator *alloc, FILE *out, size_t width, size_t from, size_t to) {
+    if (to > alloc->total_size) {
+        to = alloc->total_size;
+    }
+    if (from >= to) {
+        from = 0;
+        to = alloc->total_size;
+    }
+    if (width == 0) {
+        width = ALLOCATOR_MAP_WIDTH;
+    }
+    if (width > to - from) {
+        width = to - from;
+    }
+    print_visualization(alloc, out, width, from, to);
+}
+
+/* ============================================================================
+ * PUBLIC INTERFACE
+ * ============================================================================ */
+
+/**
+ * @brief Check that a string is a usable process name
+ * 
+ * @param name String to check
+ * @return true if valid, false otherwise
+ */
+bool allocator_valid_name(const char *name) {
+    return is_valid_process_name(name);
+}
+
+/**
+ * @brief Intern a process name
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param name Process name
+ * @return The name's id, or NO_NAME if the name is invalid or memory ran out
+ */
+AllocatorName allocator_name(Allocator *alloc, const char *name) {
+    if (!is_valid_process_name(name)) {
+        return NO_NAME;
+    }
+    return name_table_intern(&alloc->names, name);
+}
+
+/**
+ * @brief Look up a process name without interning it
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param name Process name
+ * @return The name's id, or NO_NAME if it was never interned
+ */
+AllocatorName allocator_find_name(const Allocator *alloc, const char *name) {
+    return name_table_lookup(&alloc->names, name);
+}
+
+/**
+ * @brief String of an interned name
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param name Interned name
+ * @return The name, or "" for NO_NAME and unknown ids
+ */
+const char *allocator_name_string(const Allocator *alloc, AllocatorName name) {
+    return name_string(alloc, (name < alloc->names.count) ? name : NO_NAME);
+}
+
+/**
+ * @brief Whether a process currently holds memory
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param name Interned name of the process
+ * @return true if the process owns an allocated block
+ */
+bool allocator_holds_memory(const Allocator *alloc, AllocatorName name) {
+    return name != NO_NAME && name < alloc->names.count && alloc->names.owners[name] != NIL_BLOCK;
+}
+
+/**
+ * @brief Allocate memory for a process that holds none
+ * 
+ * @param alloc Pointer to Allocator structure
+ * @param name Interned name of the requesting process
+ * @param size Size to allocate (non-zero)
+ * @param strategy Allocation strategy to use
+ * @param compact_on_fail Whether to compact a window and retry if no hole fits
+ * @param result Output (may be NULL): block allocated and compaction done
+ * @return ALLOCATOR_OK, or the reason the request failed
+ */
+AllocatorStatus allocator_request(Allocator *alloc, AllocatorName name, size_t size,
+                                  AllocationStrategy strategy, bool compact_on_fail,
+                                  AllocatorResult *result) {
+    return allocator_request_aligned(alloc, name, size, 1, strategy, compact_on_fail, result);
 }
 
 /**
- * @brief Worst Fit allocation strategy
+ * @brief Allocate memory for a process that holds none, starting on a multiple of align
  * 
- * Allocates from the largest available hole.
+ * If no hole fits and compaction on failure is enabled, for this request
+ * or for the allocator, the cheapest window of blocks is slid together and
+ * the request retried once.
  * 
  * @param alloc Pointer to Allocator structure
- * @param size Size to allocate
- * @param process_name Name of the process requesting memory
- * @return Pointer to allocated block, or NULL if allocation fails
+ * @param name Interned name of the requesting process
+ * @param size Size to allocate (non-zero)
+ * @param align Alignment of the block's start (a power of two)
+ * @param strategy Allocation strategy to use
+ * @param compact_on_fail Whether to compact a window and retry if no hole fits
+ * @param result Output (may be NULL): block allocated and compaction done
+ * @return ALLOCATOR_OK, or the reason the request failed
  */
-static MemoryBlock *allocate_worst_fit(Allocator *alloc, size_t size, const char *process_name) {
-    MemoryBlock *worst = NULL;
-    size_t worst_size = 0;
-    MemoryBlock *current = alloc->blocks;
-    
-    // Find the largest hole
-    while (current != NULL) {
-        if (current->type == BLOCK_FREE && current->size >= size) {
-            if (current->size > worst_size) {
-                worst = current;
-                worst_size = current->size;
-            }
-        }
-        current = current->next;
+AllocatorStatus allocator_request_aligned(Allocator *alloc, AllocatorName name, size_t size, size_t align,
+                                          AllocationStrategy strategy, bool compact_on_fail,
+                                          AllocatorResult *result) {
+    AllocatorResult local;
+    if (result == NULL) {
+        result = &local;
     }
+    memset(result, 0, sizeof(AllocatorResult));
     
-    if (worst == NULL) {
-        return NULL; // No suitable hole found
+    if (name == NO_NAME || name >= alloc->names.count || size == 0 || strategy > STRATEGY_NEXT_FIT ||
+        align == 0 || (align & (align - 1)) != 0) {
+        result->status = ALLOCATOR_INVALID;
+        return result->status;
+    }
+    if (alloc->names.owners[name] != NIL_BLOCK) {
+        result->status = ALLOCATOR_DUPLICATE;
+        return result->status;
     }
     
-    // Allocate from worst block
-    size_t allocated_start = worst->start;
-    size_t allocated_end = allocated_start + size;
-    
-    // Always split for worst fit (to leave largest possible remainder)
-    worst->start = allocated_end;
-    worst->size = worst->end - worst->start;
+    alloc->request_count++;
+    MemoryBlock *block = allocate_memory(alloc, size, align, name, strategy);
     
-    MemoryBlock *allocated = create_block(allocated_start, allocated_end, 
-                                          BLOCK_ALLOCATED, process_name);
-    if (allocated == NULL) {
-        worst->start = allocated_start;
-        worst->size = worst->end - worst->start;
-        return NULL;
+    // Optionally make room by sliding the cheapest window of blocks
+    if (block == NULL && (compact_on_fail || alloc->compact_on_fail)) {
+        result->compacted = compact_for_request(alloc, round_to_size_class(alloc, size), align, strategy,
+                                                &result->bytes_moved);
+        if (result->compacted) {
+            block = allocate_memory(alloc, size, align, name, strategy);
+        }
     }
     
-    // Insert allocated block
-    if (alloc->blocks == worst) {
-        allocated->next = worst;
-        alloc->blocks = allocated;
+    if (block == NULL) {
+        alloc->failed_request_count++;
+        result->status = ALLOCATOR_NO_SPACE;
     } else {
-        MemoryBlock *prev = alloc->blocks;
-        while (prev->next != worst) {
-            prev = prev->next;
-        }
-        prev->next = allocated;
-        allocated->next = worst;
+        alloc->process_count++;
+        result->status = ALLOCATOR_OK;
+        result->start = block->start;
+        result->size = block_size(block);
     }
-    
-    return allocated;
+    return result->status;
 }
 
 /**
- * @brief Allocate memory using the specified strategy
+ * @brief Find out whether a request would be satisfied, without making it
+ * 
+ * A request fits if its size, rounded up to its size class, is no larger
+ * than largest_request() for its strategy and alignment, which comes from
+ * the hole indexes. Whether compaction is sure to make room is O(1):
+ * find_compaction_window() always finds a window once the free memory
+ * covers the required hole plus the allocator's align_reserve.
  * 
  * @param alloc Pointer to Allocator structure
- * @param size Size to allocate
- * @param process_name Name of the process requesting memory
- * @param strategy Allocation strategy to use
- * @return Pointer to allocated block, or NULL if allocation fails
+ * @param size Size to allocate (non-zero)
+ * @param align Alignment of the block's start (a power of two)
+ * @param strategy Allocation strategy the request would use
+ * @param query Output: the findings
+ * @return ALLOCATOR_OK, or ALLOCATOR_INVALID if the arguments are invalid
  */
-static MemoryBlock *allocate_memory(Allocator *alloc, size_t size, const char *process_name, AllocationStrategy strategy) {
-    switch (strategy) {
-        case STRATEGY_FIRST_FIT:
-            return allocate_first_fit(alloc, size, process_name);
-        case STRATEGY_BEST_FIT:
-            return allocate_best_fit(alloc, size, process_name);
-        case STRATEGY_WORST_FIT:
-            return allocate_worst_fit(alloc, size, process_name);
-        default:
-            return NULL;
+AllocatorStatus allocator_query(Allocator *alloc, size_t size, size_t align, AllocationStrategy strategy,
+                                AllocatorQuery *query) {
+    memset(query, 0, sizeof(AllocatorQuery));
+    if (size == 0 || strategy > STRATEGY_NEXT_FIT || align == 0 || (align & (align - 1)) != 0) {
+        return ALLOCATOR_INVALID;
     }
+    
+    size_t room = largest_request(alloc, align, strategy);
+    query->size = round_to_size_class(alloc, size);
+    query->fits = query->size <= room;
+    query->largest_request = size_class_floor(alloc, room);
+    query->largest_hole = largest_hole_size(alloc);
+    query->total_free = alloc->total_free;
+    query->hole_count = alloc->hole_count;
+    query->needed = (query->size == SIZE_MAX) ? SIZE_MAX : compaction_target(query->size, align, strategy);
+    query->align_reserve = alloc->align_reserve;
+    query->compaction_fits = query->needed <= alloc->total_free &&
+                             alloc->total_free - query->needed >= alloc->align_reserve;
+    return ALLOCATOR_OK;
 }
 
-/* ============================================================================
- * MEMORY OPERATIONS
- * ============================================================================ */
-
 /**
- * @brief Release memory allocated to a process
- * 
- * Converts the allocated block to a free block and merges adjacent holes.
+ * @brief Find the window compaction would slide for a query that does not fit
  * 
  * @param alloc Pointer to Allocator structure
- * @param process_name Name of the process whose memory should be released
- * @return 0 on success, -1 if process not found
+ * @param query Findings of allocator_query(), updated in place
  */
-static int release_memory(Allocator *alloc, const char *process_name) {
-    MemoryBlock *current = alloc->blocks;
-    
-    while (current != NULL) {
-        if (current->type == BLOCK_ALLOCATED && 
-            strcmp(current->process_name, process_name) == 0) {
-            // Found the process - convert to free block
-            current->type = BLOCK_FREE;
-            current->process_name[0] = '\0';
-            alloc->process_count--;
-            
-            // Merge adjacent holes
-            merge_adjacent_holes(alloc);
-            
-            return 0;
-        }
-        current = current->next;
+void allocator_query_window(Allocator *alloc, AllocatorQuery *query) {
+    MemoryBlock *first, *last;
+    if (query->fits || query->needed > alloc->total_free) {
+        return;
     }
-    
-    return -1; // Process not found
+    query->window_checked = true;
+    query->compaction_fits = find_compaction_window(alloc, query->needed, &first, &last, &query->bytes_to_move);
 }
 
 /**
- * @brief Compact memory by moving all allocated blocks to the beginning
+ * @brief Release the memory held by a process
  * 
- * All free blocks are merged into one large block at the end.
+ * @param alloc Pointer to Allocator structure
+ * @param name Interned name of the process
+ * @return ALLOCATOR_OK, or ALLOCATOR_NOT_FOUND if it holds no memory
+ */
+AllocatorStatus allocator_release(Allocator *alloc, AllocatorName name) {
+    if (!allocator_holds_memory(alloc, name) || release_memory(alloc, name) != 0) {
+        return ALLOCATOR_NOT_FOUND;
+    }
+    return ALLOCATOR_OK;
+}
+
+/**
+ * @brief Resize the memory held by a process, in place if possible
  * 
  * @param alloc Pointer to Allocator structure
+ * @param name Interned name of the process
+ * @param new_size New size (non-zero)
+ * @param strategy Strategy to relocate the block with if it cannot stay
+ * @param result Output (may be NULL): block now held and bytes copied
+ * @return ALLOCATOR_OK, or the reason the resize failed
  */
-static void compact_memory(Allocator *alloc) {
-    // Collect all allocated blocks with their information
-    struct {
-        char process_name[MAX_PROCESS_NAME_LENGTH];
-        size_t size;
-    } allocated_info[MAX_PROCESSES];
-    int allocated_count = 0;
-    
-    MemoryBlock *current = alloc->blocks;
-    while (current != NULL && allocated_count < MAX_PROCESSES) {
-        if (current->type == BLOCK_ALLOCATED) {
-            strncpy(allocated_info[allocated_count].process_name, current->process_name, 
-                   MAX_PROCESS_NAME_LENGTH - 1);
-            allocated_info[allocated_count].process_name[MAX_PROCESS_NAME_LENGTH - 1] = '\0';
-            allocated_info[allocated_count].size = current->size;
-            allocated_count++;
-        }
-        current = current->next;
+AllocatorStatus allocator_resize(Allocator *alloc, AllocatorName name, size_t new_size,
+                                 AllocationStrategy strategy, AllocatorResult *result) {
+    AllocatorResult local;
+    if (result == NULL) {
+        result = &local;
     }
+    memset(result, 0, sizeof(AllocatorResult));
     
-    // If no allocated blocks, nothing to do
-    if (allocated_count == 0) {
-        return;
+    if (name == NO_NAME || name >= alloc->names.count || new_size == 0 || strategy > STRATEGY_NEXT_FIT) {
+        result->status = ALLOCATOR_INVALID;
+        return result->status;
     }
-    
-    // Free all existing blocks and rebuild
-    current = alloc->blocks;
-    while (current != NULL) {
-        MemoryBlock *next = current->next;
-        free_block(current);
-        current = next;
+    if (alloc->names.owners[name] == NIL_BLOCK) {
+        result->status = ALLOCATOR_NOT_FOUND;
+        return result->status;
     }
-    alloc->blocks = NULL;
     
-    // Rebuild: place allocated blocks first, then one free block
-    size_t next_start = 0;
-    for (int i = 0; i < allocated_count; i++) {
-        size_t block_size = allocated_info[i].size;
-        
-        // Create new allocated block at compacted location
-        MemoryBlock *new_block = create_block(next_start, next_start + block_size, 
-                                              BLOCK_ALLOCATED, allocated_info[i].process_name);
-        if (new_block == NULL) {
-            // Error - cleanup and exit
-            allocator_cleanup(alloc);
-            allocator_init(alloc, alloc->total_size);
-            return;
-        }
-        
-        insert_block(alloc, new_block);
-        next_start += block_size;
+    size_t kept = alloc->names.requested[name];
+    if (kept > new_size) {
+        kept = new_size;
     }
+    MemoryBlock *block = resize_memory(alloc, name, new_size, strategy, &result->relocated);
     
-    // Create one large free block for remaining space
-    if (next_start < alloc->total_size) {
-        MemoryBlock *free_block = create_block(next_start, alloc->total_size, BLOCK_FREE, "");
-        if (free_block != NULL) {
-            insert_block(alloc, free_block);
-        }
+    if (block == NULL) {
+        alloc->failed_resize_count++;
+        result->status = ALLOCATOR_NO_SPACE;
+        return result->status;
+    }
+    if (result->relocated) {
+        alloc->resize_relocated_count++;
+        alloc->resize_bytes_copied += kept;
+        result->bytes_moved = kept;
+    } else {
+        alloc->resize_in_place_count++;
     }
+    result->status = ALLOCATOR_OK;
+    result->start = block->start;
+    result->size = block_size(block);
+    return result->status;
 }
 
-/* ============================================================================
- * STATISTICS AND REPORTING
- * ============================================================================ */
-
 /**
- * @brief Calculate fragmentation metrics
+ * @brief Compact memory, optionally within a byte budget
  * 
  * @param alloc Pointer to Allocator structure
- * @param total_allocated Output: total allocated memory
- * @param total_free Output: total free memory
- * @param largest_hole Output: size of largest free block
- * @param external_frag Output: external fragmentation percentage
- * @param avg_hole_size Output: average hole size
+ * @param max_bytes_moved Most bytes to move (SIZE_MAX for no limit)
+ * @return Number of bytes moved
  */
-static void calculate_fragmentation(Allocator *alloc, size_t *total_allocated, size_t *total_free, 
-                                    size_t *largest_hole, double *external_frag, double *avg_hole_size) {
-    *total_allocated = 0;
-    *total_free = 0;
-    *largest_hole = 0;
-    int hole_count = 0;
-    
-    MemoryBlock *current = alloc->blocks;
-    while (current != NULL) {
-        if (current->type == BLOCK_ALLOCATED) {
-            *total_allocated += current->size;
-        } else {
-            *total_free += current->size;
-            if (current->size > *largest_hole) {
-                *largest_hole = current->size;
-            }
-            hole_count++;
-        }
-        current = current->next;
-    }
-    
-    // Calculate external fragmentation: (1 - largest_free_block / total_free) * 100
-    if (*total_free > 0) {
-        *external_frag = (1.0 - (double)(*largest_hole) / (double)(*total_free)) * 100.0;
-    } else {
-        *external_frag = 0.0;
-    }
-    
-    // Calculate average hole size
-    if (hole_count > 0) {
-        *avg_hole_size = (double)(*total_free) / (double)hole_count;
-    } else {
-        *avg_hole_size = 0.0;
-    }
+size_t allocator_compact(Allocator *alloc, size_t max_bytes_moved) {
+    return compact_memory(alloc, max_bytes_moved);
 }
 
 /**
- * @brief Print memory visualization map
+ * @brief Apply an array of requests, releases, resizes and compactions in order
  * 
  * @param alloc Pointer to Allocator structure
+ * @param ops Operations to apply
+ * @param count Number of operations
+ * @param results Output: one result per operation
+ * @return Number of operations that succeeded
  */
-static void print_visualization(Allocator *alloc) {
-    char map[VISUALIZATION_WIDTH + 1];
-    map[VISUALIZATION_WIDTH] = '\0';
-    
-    // Initialize map
-    for (int i = 0; i < VISUALIZATION_WIDTH; i++) {
-        map[i] = '.';
-    }
-    
-    // Mark allocated regions
-    MemoryBlock *current = alloc->blocks;
-    while (current != NULL) {
-        if (current->type == BLOCK_ALLOCATED) {
-            // Calculate which characters this block occupies
-            double start_ratio = (double)current->start / (double)alloc->total_size;
-            double end_ratio = (double)current->end / (double)alloc->total_size;
-            
-            int start_char = (int)(start_ratio * VISUALIZATION_WIDTH);
-            int end_char = (int)(end_ratio * VISUALIZATION_WIDTH);
-            
-            // Ensure we don't go out of bounds
-            if (start_char < 0) start_char = 0;
-            if (end_char > VISUALIZATION_WIDTH) end_char = VISUALIZATION_WIDTH;
-            if (start_char >= VISUALIZATION_WIDTH) start_char = VISUALIZATION_WIDTH - 1;
-            
-            for (int i = start_char; i < end_char; i++) {
-                map[i] = '#';
-            }
+size_t allocator_apply_batch(Allocator *alloc, const AllocatorOp *ops, size_t count,
+                             AllocatorResult *results) {
+    size_t succeeded = 0;
+    for (size_t i = 0; i < count; i++) {
+        const AllocatorOp *op = &ops[i];
+        switch (op->type) {
+            case ALLOCATOR_OP_REQUEST:
+                allocator_request_aligned(alloc, op->name, op->size, (op->align > 1) ? op->align : 1, op->strategy,
+                                          op->compact_on_fail, &results[i]);
+                break;
+            case ALLOCATOR_OP_RELEASE:
+                memset(&results[i], 0, sizeof(AllocatorResult));
+                results[i].status = allocator_release(alloc, op->name);
+                break;
+            case ALLOCATOR_OP_COMPACT:
+                memset(&results[i], 0, sizeof(AllocatorResult));
+                results[i].bytes_moved = allocator_compact(alloc, op->size);
+                break;
+            case ALLOCATOR_OP_RESIZE:
+                allocator_resize(alloc, op->name, op->size, op->strategy, &results[i]);
+                break;
+            default:
+                memset(&results[i], 0, sizeof(AllocatorResult));
+                results[i].status = ALLOCATOR_INVALID;
+                break;
+        }
+        if (results[i].status == ALLOCATOR_OK) {
+            succeeded++;
         }
-        current = current->next;
-    }
-    
-    printf("[%s]\n", map);
-    printf("^0");
-    for (int i = 0; i < VISUALIZATION_WIDTH - 2; i++) {
-        printf(" ");
     }
-    printf("^%zu\n", alloc->total_size);
+    return succeeded;
 }
 
 /**
- * @brief Print statistics report
+ * @brief Fill in summary figures of the allocator's current state
  * 
  * @param alloc Pointer to Allocator structure
- * @param visualize Whether to include visualization
+ * @param stats Output: summary figures
  */
-static void print_statistics(Allocator *alloc, bool visualize) {
-    // Print allocated memory
-    printf("Allocated memory:\n");
-    MemoryBlock *current = alloc->blocks;
-    int allocated_count = 0;
-    while (current != NULL) {
-        if (current->type == BLOCK_ALLOCATED) {
-            printf("Process %s: Start = %zu KB, End = %zu KB, Size = %zu KB\n",
-                   current->process_name,
-                   current->start / 1024,
-                   current->end / 1024,
-                   current->size / 1024);
-            allocated_count++;
-        }
-        current = current->next;
-    }
-    if (allocated_count == 0) {
-        printf("(No allocated memory)\n");
-    }
-    
-    // Print free memory
-    printf("Free memory:\n");
-    current = alloc->blocks;
-    int hole_num = 1;
-    int hole_count = 0;
-    while (current != NULL) {
-        if (current->type == BLOCK_FREE) {
-            printf("Hole %d: Start = %zu KB, End = %zu KB, Size = %zu KB\n",
-                   hole_num++,
-                   current->start / 1024,
-                   current->end / 1024,
-                   current->size / 1024);
-            hole_count++;
-        }
-        current = current->next;
-    }
-    if (hole_count == 0) {
-        printf("(No free memory)\n");
-    }
-    
-    // Calculate and print summary
-    size_t total_allocated, total_free, largest_hole;
-    double external_frag, avg_hole_size;
-    
-    calculate_fragmentation(alloc, &total_allocated, &total_free, &largest_hole, 
-                          &external_frag, &avg_hole_size);
-    
-    printf("Summary:\n");
-    printf("Total allocated: %zu KB\n", total_allocated / 1024);
-    printf("Total free: %zu KB\n", total_free / 1024);
-    printf("Largest hole: %zu KB\n", largest_hole / 1024);
-    printf("External fragmentation: %.1f%% (1-largest free block/total free memory)\n", external_frag);
-    printf("Average hole size: %.0f KB\n", avg_hole_size / 1024);
-    
-    // Print visualization if requested
-    if (visualize) {
-        printf("\n");
-        print_visualization(alloc);
+void allocator_get_stats(Allocator *alloc, AllocatorStats *stats) {
+    double avg_hole_size, internal_frag, rounding_frag;
+    calculate_fragmentation(alloc, &stats->total_allocated, &stats->total_free, &stats->largest_hole,
+                            &stats->hole_count, &stats->external_fragmentation, &avg_hole_size,
+                            &internal_frag, &rounding_frag);
+    stats->total_size = alloc->total_size;
+    stats->process_count = (size_t)alloc->process_count;
+    stats->internal_waste = alloc->internal_waste;
+    stats->rounding_waste = alloc->rounding_waste;
+    stats->request_count = alloc->request_count;
+    stats->failed_request_count = alloc->failed_request_count;
+    stats->block_count = alloc->pool.live_nodes;
+    stats->peak_block_count = alloc->pool.high_water;
+    memcpy(stats->searches, alloc->searches, sizeof(stats->searches));
+    memcpy(stats->probes, alloc->search_probes, sizeof(stats->probes));
+    stats->resize_in_place_count = alloc->resize_in_place_count;
+    stats->resize_relocated_count = alloc->resize_relocated_count;
+    stats->failed_resize_count = alloc->failed_resize_count;
+    stats->resize_bytes_copied = alloc->resize_bytes_copied;
+}
+
+/**
+ * @brief Short description of a status
+ * 
+ * @param status Status to describe
+ * @return Static string
+ */
+const char *allocator_status_string(AllocatorStatus status) {
+    switch (status) {
+        case ALLOCATOR_OK:
+            return "ok";
+        case ALLOCATOR_NO_SPACE:
+            return "insufficient memory";
+        case ALLOCATOR_DUPLICATE:
+            return "process already exists";
+        case ALLOCATOR_NOT_FOUND:
+            return "process not found";
+        case ALLOCATOR_INVALID:
+            return "invalid operation";
+        default:
+            return "unknown status";
     }
 }
 
 /* ============================================================================
- * COMMAND PARSING AND EXECUTION
+ * SNAPSHOTS
  * ============================================================================ */
 
 /**
- * @brief Parse allocation strategy character
+ * @brief Bytes each snapshot array takes, from the capacities in the allocator
  * 
- * @param strategy_char Character representing strategy (F, B, or W)
- * @return AllocationStrategy enum value
+ * @param alloc Allocator whose arrays are measured
+ * @param sizes Output: size of each SnapshotSection
  */
-static AllocationStrategy parse_strategy(char strategy_char) {
-    switch (toupper(strategy_char)) {
-        case 'F':
-            return STRATEGY_FIRST_FIT;
-        case 'B':
-            return STRATEGY_BEST_FIT;
-        case 'W':
-            return STRATEGY_WORST_FIT;
-        default:
-            return STRATEGY_FIRST_FIT; // Default to first fit
-    }
+static void snapshot_sizes(const Allocator *alloc, size_t sizes[SNAPSHOT_SECTION_COUNT]) {
+    sizes[SNAPSHOT_SLABS] = alloc->pool.slab_count * BLOCK_POOL_SLAB_SIZE * sizeof(MemoryBlock);
+    sizes[SNAPSHOT_BUDDY_CHUNKS] = (size_t)alloc->buddy.chunk_capacity * sizeof(BuddyChunk);
+    sizes[SNAPSHOT_TLSF_NEXT] = alloc->tlsf.link_capacity * sizeof(BlockId);
+    sizes[SNAPSHOT_TLSF_PREV] = alloc->tlsf.link_capacity * sizeof(BlockId);
+    sizes[SNAPSHOT_NAME_CHARS] = alloc->names.chars_capacity;
+    sizes[SNAPSHOT_NAME_OFFSETS] = (size_t)alloc->names.id_capacity * sizeof(size_t);
+    sizes[SNAPSHOT_NAME_OWNERS] = (size_t)alloc->names.id_capacity * sizeof(BlockId);
+    sizes[SNAPSHOT_NAME_REQUESTED] = (size_t)alloc->names.id_capacity * sizeof(size_t);
+    sizes[SNAPSHOT_NAME_SLOTS] = alloc->names.slot_capacity * sizeof(NameId);
 }
 
 /**
- * @brief Process a single command
+ * @brief Write an array followed by zero padding up to SNAPSHOT_ALIGNMENT
  * 
- * @param alloc Pointer to Allocator structure
- * @param command Command string to process
+ * @param file Output file
+ * @param array Array to write (may be NULL if bytes is 0)
+ * @param bytes Size of the array
+ * @return true on success, false on a write error
  */
-static void process_command(Allocator *alloc, const char *command) {
-    char cmd_copy[MAX_LINE_LENGTH];
-    strncpy(cmd_copy, command, sizeof(cmd_copy) - 1);
-    cmd_copy[sizeof(cmd_copy) - 1] = '\0';
-    
-    trim_whitespace(cmd_copy);
-    
-    // Handle empty commands
-    if (strlen(cmd_copy) == 0) {
-        return;
-    }
-    
-    // Parse command
-    if (strncmp(cmd_copy, "RQ ", 3) == 0) {
-        // Request memory: RQ <process> <size> <F|B|W>
-        char process_name[MAX_PROCESS_NAME_LENGTH];
-        char size_str[64];
-        char strategy_char;
-        
-        if (sscanf(cmd_copy + 3, "%s %s %c", process_name, size_str, &strategy_char) != 3) {
-            printf("Error: Invalid RQ command format. Use: RQ <process> <size> <F|B|W>\n");
-            return;
-        }
-        
-        // Validate process name
-        if (!is_valid_process_name(process_name)) {
-            printf("Error: Invalid process name '%s'\n", process_name);
-            return;
-        }
-        
-        // Check for duplicate process name
-        MemoryBlock *current = alloc->blocks;
-        while (current != NULL) {
-            if (current->type == BLOCK_ALLOCATED && 
-                strcmp(current->process_name, process_name) == 0) {
-                printf("Error: Process '%s' already exists\n", process_name);
-                return;
-            }
-            current = current->next;
-        }
-        
-        size_t size = parse_size(size_str);
-        if (size == 0) {
-            printf("Error: Invalid size '%s'\n", size_str);
-            return;
-        }
-        
-        AllocationStrategy strategy = parse_strategy(strategy_char);
-        MemoryBlock *block = allocate_memory(alloc, size, process_name, strategy);
-        
-        if (block == NULL) {
-            printf("Error: Insufficient memory to allocate %zu bytes for process '%s'\n", size, process_name);
-        } else {
-            alloc->process_count++;
-        }
-        
-    } else if (strncmp(cmd_copy, "RL ", 3) == 0) {
-        // Release memory: RL <process>
-        char process_name[MAX_PROCESS_NAME_LENGTH];
-        
-        if (sscanf(cmd_copy + 3, "%s", process_name) != 1) {
-            printf("Error: Invalid RL command format. Use: RL <process>\n");
-            return;
-        }
-        
-        if (release_memory(alloc, process_name) != 0) {
-            printf("Error: Process '%s' not found\n", process_name);
-        }
-        
-    } else if (strcmp(cmd_copy, "C") == 0) {
-        // Compact memory
-        compact_memory(alloc);
-        
-    } else if (strncmp(cmd_copy, "STAT", 4) == 0) {
-        // Status report: STAT or STAT -v
-        bool visualize = false;
-        if (strstr(cmd_copy, "-v") != NULL) {
-            visualize = true;
-        }
-        print_statistics(alloc, visualize);
-        
-    } else if (strncmp(cmd_copy, "SIM ", 4) == 0) {
-        // Simulation mode: SIM <filename>
-        char filename[MAX_LINE_LENGTH];
-        
-        if (sscanf(cmd_copy + 4, "%s", filename) != 1) {
-            printf("Error: Invalid SIM command format. Use: SIM <filename>\n");
-            return;
-        }
-        
-        execute_simulation(alloc, filename);
-        
-    } else if (strcmp(cmd_copy, "X") == 0) {
-        // Exit - handled in main loop
-        return;
-        
-    } else {
-        printf("Error: Unknown command '%s'\n", cmd_copy);
-        printf("Valid commands: RQ, RL, C, STAT, STAT -v, SIM, X\n");
-    }
+static bool snapshot_write_array(FILE *file, const void *array, size_t bytes) {
+    static const uint8_t padding[SNAPSHOT_ALIGNMENT] = {0};
+    size_t pad = (SNAPSHOT_ALIGNMENT - bytes % SNAPSHOT_ALIGNMENT) % SNAPSHOT_ALIGNMENT;
+    return (bytes == 0 || fwrite(array, 1, bytes, file) == bytes) &&
+           fwrite(padding, 1, pad, file) == pad;
 }
 
 /**
- * @brief Execute commands from a file
+ * @brief Fold an array, and the padding written after it, into a snapshot checksum
  * 
- * @param alloc Pointer to Allocator structure
- * @param filename Name of the file containing commands
+ * The array is read as 64-bit words, zero-filled past its end up to the
+ * next SNAPSHOT_ALIGNMENT boundary just as snapshot_write_array() pads it,
+ * so hashing the arrays one by one gives the same value as hashing the
+ * file they are written to in one go.
+ * 
+ * @param hash Checksum so far (SNAPSHOT_HASH_SEED to start)
+ * @param array Array to fold in (may be NULL if bytes is 0)
+ * @param bytes Size of the array
+ * @return Updated checksum
  */
-static void execute_simulation(Allocator *alloc, const char *filename) {
-    FILE *file = fopen(filename, "r");
-    if (file == NULL) {
-        printf("Error: Cannot open file '%s'\n", filename);
-        return;
-    }
-    
-    char line[MAX_LINE_LENGTH];
-    
-    while (fgets(line, sizeof(line), file) != NULL) {
-        
-        // Remove trailing newline
-        size_t len = strlen(line);
-        if (len > 0 && line[len - 1] == '\n') {
-            line[len - 1] = '\0';
-        }
-        
-        // Skip empty lines and comments
-        trim_whitespace(line);
-        if (strlen(line) == 0 || line[0] == '#') {
-            continue;
+static uint64_t snapshot_hash(uint64_t hash, const void *array, size_t bytes) {
+    const uint8_t *data = (const uint8_t *)array;
+    size_t padded = (bytes + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+    for (size_t i = 0; i < padded; i += sizeof(uint64_t)) {
+        uint64_t word = 0;
+        if (i < bytes) {
+            memcpy(&word, data + i, (bytes - i < sizeof(uint64_t)) ? bytes - i : sizeof(uint64_t));
         }
-        
-        // Process command
-        process_command(alloc, line);
+        hash = (hash ^ word) * SNAPSHOT_HASH_PRIME;
     }
-    
-    fclose(file);
+    return hash;
 }
 
-/* ============================================================================
- * UTILITY FUNCTIONS
- * ============================================================================ */
-
 /**
- * @brief Parse a size string (supports KB, MB suffixes)
+ * @brief Write the allocator's whole state to a snapshot file
  * 
- * @param str String to parse
- * @return Size in bytes, or 0 on error
+ * The file is written as path.tmp and renamed over path, so saving onto
+ * the snapshot currently loaded never truncates the pages the allocator
+ * is still reading from, and a failed save leaves the old file intact.
+ * 
+ * @param alloc Allocator to save
+ * @param path Path of the file to write
+ * @return true on success, false if the file could not be written
  */
-static size_t parse_size(const char *str) {
-    if (str == NULL || strlen(str) == 0) {
-        return 0;
+bool allocator_save(const Allocator *alloc, const char *path) {
+    size_t sizes[SNAPSHOT_SECTION_COUNT];
+    snapshot_sizes(alloc, sizes);
+    
+    // The header is padded like the arrays, so every offset stays aligned
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(SnapshotHeader));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.header_size = (uint32_t)sizeof(SnapshotHeader);
+    header.block_size = sizeof(MemoryBlock);
+    uint64_t offset = (sizeof(SnapshotHeader) + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+    for (int i = 0; i < SNAPSHOT_SECTION_COUNT; i++) {
+        header.offsets[i] = offset;
+        offset += (sizes[i] + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
     }
+    header.length = offset;
     
-    char *endptr;
-    long long value = strtoll(str, &endptr, 10);
+    header.state = *alloc;
+    header.state.pool.slabs = NULL;
+    header.state.pool.mapped_slabs = 0;
+    header.state.buddy.chunks = NULL;
+    header.state.buddy.mapped = false;
+    header.state.tlsf.next = NULL;
+    header.state.tlsf.prev = NULL;
+    header.state.tlsf.mapped = false;
+    memset(&header.state.occupancy, 0, sizeof(OccupancyTree)); // Rebuilt on the first STAT -v
+    header.state.names.chars = NULL;
+    header.state.names.offsets = NULL;
+    header.state.names.owners = NULL;
+    header.state.names.requested = NULL;
+    header.state.names.slots = NULL;
+    header.state.names.mapped = false;
+    header.state.snapshot = NULL;
+    header.state.snapshot_length = 0;
     
-    if (value < 0) {
-        return 0;
+    uint64_t checksum = snapshot_hash(SNAPSHOT_HASH_SEED, &header, sizeof(SnapshotHeader));
+    for (size_t i = 0; i < alloc->pool.slab_count; i++) {
+        checksum = snapshot_hash(checksum, alloc->pool.slabs[i], BLOCK_POOL_SLAB_SIZE * sizeof(MemoryBlock));
     }
+    checksum = snapshot_hash(checksum, alloc->buddy.chunks, sizes[SNAPSHOT_BUDDY_CHUNKS]);
+    checksum = snapshot_hash(checksum, alloc->tlsf.next, sizes[SNAPSHOT_TLSF_NEXT]);
+    checksum = snapshot_hash(checksum, alloc->tlsf.prev, sizes[SNAPSHOT_TLSF_PREV]);
+    checksum = snapshot_hash(checksum, alloc->names.chars, sizes[SNAPSHOT_NAME_CHARS]);
+    checksum = snapshot_hash(checksum, alloc->names.offsets, sizes[SNAPSHOT_NAME_OFFSETS]);
+    checksum = snapshot_hash(checksum, alloc->names.owners, sizes[SNAPSHOT_NAME_OWNERS]);
+    checksum = snapshot_hash(checksum, alloc->names.requested, sizes[SNAPSHOT_NAME_REQUESTED]);
+    header.checksum = snapshot_hash(checksum, alloc->names.slots, sizes[SNAPSHOT_NAME_SLOTS]);
     
-    // Check for suffix
-    while (*endptr == ' ' || *endptr == '\t') {
-        endptr++;
+    // The arrays may still live in a mapping of path itself, so the file is
+    // written beside it and renamed over it only once it is complete
+    size_t path_length = strlen(path);
+    char *temp_path = (char *)malloc(path_length + sizeof(SNAPSHOT_TEMP_SUFFIX));
+    if (temp_path == NULL) {
+        return false;
     }
-    
-    if (*endptr == '\0') {
-        // No suffix - assume bytes
-        return (size_t)value;
+    memcpy(temp_path, path, path_length);
+    memcpy(temp_path + path_length, SNAPSHOT_TEMP_SUFFIX, sizeof(SNAPSHOT_TEMP_SUFFIX));
+    FILE *file = fopen(temp_path, "wb");
+    if (file == NULL) {
+        free(temp_path);
+        return false;
     }
-    
-    // Check for KB, MB suffixes
-    if (strcasecmp(endptr, "KB") == 0 || strcasecmp(endptr, "K") == 0) {
-        return (size_t)(value * 1024);
-    } else if (strcasecmp(endptr, "MB") == 0 || strcasecmp(endptr, "M") == 0) {
-        return (size_t)(value * 1024 * 1024);
-    } else if (strcasecmp(endptr, "GB") == 0 || strcasecmp(endptr, "G") == 0) {
-        return (size_t)(value * 1024ULL * 1024 * 1024);
+    bool ok = snapshot_write_array(file, &header, sizeof(SnapshotHeader));
+    for (size_t i = 0; ok && i < alloc->pool.slab_count; i++) {
+        // A slab is a multiple of 1024 bytes, so the slabs need no padding
+        ok = fwrite(alloc->pool.slabs[i], sizeof(MemoryBlock), BLOCK_POOL_SLAB_SIZE, file) == BLOCK_POOL_SLAB_SIZE;
     }
-    
-    // Try to parse as plain number
-    value = strtoll(str, &endptr, 10);
-    if (*endptr == '\0' && value >= 0) {
-        return (size_t)value;
+    ok = ok && snapshot_write_array(file, alloc->buddy.chunks, sizes[SNAPSHOT_BUDDY_CHUNKS]);
+    ok = ok && snapshot_write_array(file, alloc->tlsf.next, sizes[SNAPSHOT_TLSF_NEXT]);
+    ok = ok && snapshot_write_array(file, alloc->tlsf.prev, sizes[SNAPSHOT_TLSF_PREV]);
+    ok = ok && snapshot_write_array(file, alloc->names.chars, sizes[SNAPSHOT_NAME_CHARS]);
+    ok = ok && snapshot_write_array(file, alloc->names.offsets, sizes[SNAPSHOT_NAME_OFFSETS]);
+    ok = ok && snapshot_write_array(file, alloc->names.owners, sizes[SNAPSHOT_NAME_OWNERS]);
+    ok = ok && snapshot_write_array(file, alloc->names.requested, sizes[SNAPSHOT_NAME_REQUESTED]);
+    ok = ok && snapshot_write_array(file, alloc->names.slots, sizes[SNAPSHOT_NAME_SLOTS]);
+    ok = fclose(file) == 0 && ok && rename(temp_path, path) == 0;
+    if (!ok) {
+        remove(temp_path);
     }
-    
-    return 0;
+    free(temp_path);
+    return ok;
 }
 
 /**
- * @brief Trim leading and trailing whitespace from a string
+ * @brief Locate one array inside a mapped snapshot
  * 
- * @param str String to trim (modified in place)
+ * @param base Start of the mapping
+ * @param header The snapshot's header
+ * @param sizes Size of each array
+ * @param section Array to locate
+ * @return The array, or NULL if it is empty
  */
-static void trim_whitespace(char *str) {
-    if (str == NULL) {
-        return;
+static void *snapshot_array(uint8_t *base, const SnapshotHeader *header, const size_t sizes[SNAPSHOT_SECTION_COUNT],
+                            SnapshotSection section) {
+    return (sizes[section] == 0) ? NULL : base + header->offsets[section];
+}
+
+/**
+ * @brief Replace the allocator's state with a snapshot written by allocator_save()
+ * 
+ * The file is mapped copy-on-write and the allocator's arrays point
+ * straight into the mapping: nothing is copied or allocated per block,
+ * apart from one pointer per slab of BLOCK_POOL_SLAB_SIZE nodes.
+ * An array that has to grow is first moved to the heap. The header and
+ * the array bounds are checked, and the file is read through once to
+ * match its checksum, so a damaged or truncated file is turned down
+ * rather than followed; past that, the contents are trusted as written
+ * by allocator_save().
+ * 
+ * @param alloc Allocator to load into
+ * @param path Path of the snapshot
+ * @return true on success; false if the file cannot be read or is not a
+ *         snapshot of this build, leaving the allocator unchanged
+ */
+bool allocator_load(Allocator *alloc, const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
     }
-    
-    // Trim leading whitespace
-    char *start = str;
-    while (*start == ' ' || *start == '\t' || *start == '\n' || *start == '\r') {
-        start++;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(SnapshotHeader)) {
+        close(fd);
+        return false;
+    }
+    size_t length = (size_t)info.st_size;
+    uint8_t *base = (uint8_t *)mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return false;
     }
     
-    // Trim trailing whitespace
-    char *end = start + strlen(start) - 1;
-    while (end > start && (*end == ' ' || *end == '\t' || *end == '\n' || *end == '\r')) {
-        *end = '\0';
-        end--;
+    // Bound every capacity by the file length first, so the sizes cannot overflow
+    SnapshotHeader *header = (SnapshotHeader *)base;
+    const Allocator *state = &header->state;
+    bool valid = memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) == 0 &&
+                 header->version == SNAPSHOT_VERSION && header->header_size == sizeof(SnapshotHeader) &&
+                 header->block_size == sizeof(MemoryBlock) && header->length == length &&
+                 state->total_size > 0 && state->index_mode <= HOLE_INDEX_TREE &&
+                 state->size_class_count <= ALLOCATOR_MAX_SIZE_CLASSES &&
+                 state->pool.slab_count > 0 && state->pool.slab_count <= state->pool.slab_capacity &&
+                 state->pool.slab_count <= length / (BLOCK_POOL_SLAB_SIZE * sizeof(MemoryBlock)) &&
+                 state->pool.slab_used <= BLOCK_POOL_SLAB_SIZE &&
+                 state->blocks != NIL_BLOCK && state->blocks <= state->pool.slab_count * BLOCK_POOL_SLAB_SIZE &&
+                 state->buddy.chunk_capacity <= length / sizeof(BuddyChunk) &&
+                 state->tlsf.link_capacity <= length / sizeof(BlockId) &&
+                 state->names.chars_capacity <= length && state->names.chars_used <= state->names.chars_capacity &&
+                 state->names.id_capacity <= length / sizeof(size_t) &&
+                 state->names.count >= 1 && state->names.count <= state->names.id_capacity &&
+                 state->names.slot_capacity > 0 && state->names.slot_capacity <= length / sizeof(NameId) &&
+                 (state->names.slot_capacity & (state->names.slot_capacity - 1)) == 0;
+    if (valid) {
+        // The mapping is private, so the stored checksum can be zeroed to recompute it
+        uint64_t checksum = header->checksum;
+        header->checksum = 0;
+        valid = snapshot_hash(SNAPSHOT_HASH_SEED, base, length) == checksum;
+        header->checksum = checksum;
+    }
+    size_t sizes[SNAPSHOT_SECTION_COUNT];
+    if (valid) {
+        snapshot_sizes(state, sizes);
+        for (int i = 0; i < SNAPSHOT_SECTION_COUNT && valid; i++) {
+            valid = header->offsets[i] % SNAPSHOT_ALIGNMENT == 0 && header->offsets[i] <= length &&
+                    sizes[i] <= length - header->offsets[i];
+        }
+    }
+    MemoryBlock **slabs = valid ? (MemoryBlock **)calloc(state->pool.slab_capacity, sizeof(MemoryBlock *)) : NULL;
+    if (slabs == NULL) {
+        munmap(base, length);
+        return false;
     }
     
-    // Move trimmed string to beginning
-    if (start != str) {
-        memmove(str, start, strlen(start) + 1);
+    MemoryBlock *nodes = (MemoryBlock *)snapshot_array(base, header, sizes, SNAPSHOT_SLABS);
+    for (size_t i = 0; i < state->pool.slab_count; i++) {
+        slabs[i] = nodes + i * BLOCK_POOL_SLAB_SIZE;
     }
+    
+    release_storage(alloc);
+    *alloc = *state;
+    alloc->pool.slabs = slabs;
+    alloc->pool.mapped_slabs = state->pool.slab_count;
+    alloc->buddy.chunks = (BuddyChunk *)snapshot_array(base, header, sizes, SNAPSHOT_BUDDY_CHUNKS);
+    alloc->buddy.mapped = true;
+    alloc->tlsf.next = (BlockId *)snapshot_array(base, header, sizes, SNAPSHOT_TLSF_NEXT);
+    alloc->tlsf.prev = (BlockId *)snapshot_array(base, header, sizes, SNAPSHOT_TLSF_PREV);
+    alloc->tlsf.mapped = true;
+    alloc->names.chars = (char *)snapshot_array(base, header, sizes, SNAPSHOT_NAME_CHARS);
+    alloc->names.offsets = (size_t *)snapshot_array(base, header, sizes, SNAPSHOT_NAME_OFFSETS);
+    alloc->names.owners = (BlockId *)snapshot_array(base, header, sizes, SNAPSHOT_NAME_OWNERS);
+    alloc->names.requested = (size_t *)snapshot_array(base, header, sizes, SNAPSHOT_NAME_REQUESTED);
+    alloc->names.slots = (NameId *)snapshot_array(base, header, sizes, SNAPSHOT_NAME_SLOTS);
+    alloc->names.mapped = true;
+    alloc->snapshot = base;
+    alloc->snapshot_length = length;
+    return true;
 }
 
+/* ============================================================================
+ * UTILITY FUNCTIONS
+ * ============================================================================ */
+
 /**
  * @brief Check if a process name is valid
  * 
@@ -1111,3 +4545,49 @@ static bool is_valid_process_name(const char *name) {
     return true;
 }
 
+/**
+ * @brief Largest unit (0 = bytes, 1 = KB, ... 4 = TB) that divides a byte count
+ * 
+ * Passing several counts or'ed together gives a unit that divides them all.
+ * 
+ * @param bytes Byte count (0 gives bytes)
+ * @return Unit index
+ */
+static int size_unit(size_t bytes) {
+    int unit = 0;
+    while (unit < 4 && bytes != 0 && bytes % 1024 == 0) {
+        bytes /= 1024;
+        unit++;
+    }
+    return unit;
+}
+
+/**
+ * @brief Write a byte count exactly in a given unit, which must divide it
+ * 
+ * @param bytes Byte count
+ * @param unit Unit index, as returned by size_unit()
+ * @param text Buffer to write to
+ * @return text
+ */
+static const char *format_size_in(size_t bytes, int unit, char text[SIZE_TEXT_LENGTH]) {
+    static const char *const units[] = {"bytes", "KB", "MB", "GB", "TB"};
+    
+    bytes >>= 10 * unit;
+    snprintf(text, SIZE_TEXT_LENGTH, "%zu %s", bytes, (bytes == 1 && unit == 0) ? "byte" : units[unit]);
+    return text;
+}
+
+/**
+ * @brief Write a byte count exactly, in the largest unit that divides it
+ * 
+ * 40960 is written as "40 KB" but 40000 as "40000 bytes", so no figure in
+ * a report is rounded, however large the memory.
+ * 
+ * @param bytes Byte count
+ * @param text Buffer to write to
+ * @return text
+ */
+static const char *format_size(size_t bytes, char text[SIZE_TEXT_LENGTH]) {
+    return format_size_in(bytes, size_unit(bytes), text);
+}
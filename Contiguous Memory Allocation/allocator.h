@@ -0,0 +1,450 @@
+/**
+ * @file allocator.h
+ * @brief Contiguous Memory Allocator library interface
+ *
+ * Simulates contiguous memory allocation over a range of addresses
+ * [0, total_size). Each Allocator is an independent instance behind an
+ * opaque handle, so a program can run any number of them side by side.
+ *
+ * Processes are identified by interned names: allocator_name() maps a
+ * string to a small AllocatorName once, and the request and release calls
+ * take that id. None of the calls below print anything, apart from
+ * allocator_print_statistics() which writes to the stream it is given.
+ *
+ * @author Gabriel Giancarlo
+ * @date 2025
+ */
+
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define ALLOCATOR_MAX_NAME_LENGTH 64 ///< Process names are shorter than this
+#define ALLOCATOR_NO_NAME 0          ///< AllocatorName that names no process
+#define ALLOCATOR_STAT_VISUALIZE 0x01 ///< Report flag: append the memory map (STAT -v)
+#define ALLOCATOR_STAT_TLSF 0x02     ///< Report flag: append the TLSF bitmaps (STAT -t)
+#define ALLOCATOR_STAT_SUMMARY 0x04  ///< Report flag: skip the block listing (STAT -s)
+#define ALLOCATOR_MAP_WIDTH 50       ///< Columns of the memory map STAT -v prints by default
+#define ALLOCATOR_STRATEGY_COUNT 6   ///< Number of AllocationStrategy values
+#define ALLOCATOR_MAX_SIZE_CLASSES 64 ///< Most size classes allocator_set_size_classes() accepts
+
+/* ============================================================================
+ * ENUMERATIONS
+ * ============================================================================ */
+
+/**
+ * @enum AllocationStrategy
+ * @brief Enumeration of supported allocation strategies
+ */
+typedef enum {
+    STRATEGY_FIRST_FIT = 0,
+    STRATEGY_BEST_FIT,
+    STRATEGY_WORST_FIT,
+    STRATEGY_BUDDY,
+    STRATEGY_TLSF,
+    STRATEGY_NEXT_FIT
+} AllocationStrategy;
+
+/**
+ * @enum HoleIndexMode
+ * @brief How free holes are located by the allocation strategies
+ */
+typedef enum {
+    HOLE_INDEX_LIST = 0,             ///< Walk the whole block list (reference behaviour)
+    HOLE_INDEX_SEGREGATED,           ///< Power-of-two segregated free lists
+    HOLE_INDEX_TREE                  ///< AVL tree keyed by (size, start)
+} HoleIndexMode;
+
+/**
+ * @enum AllocatorStatus
+ * @brief Outcome of a request or release
+ */
+typedef enum {
+    ALLOCATOR_OK = 0,                ///< The operation was carried out
+    ALLOCATOR_NO_SPACE,              ///< No hole was large enough for the request
+    ALLOCATOR_DUPLICATE,             ///< The process already holds memory
+    ALLOCATOR_NOT_FOUND,             ///< The process holds no memory
+    ALLOCATOR_INVALID                ///< Unknown name or operation, or a zero size
+} AllocatorStatus;
+
+/**
+ * @enum AllocatorOpType
+ * @brief Kinds of operation accepted by allocator_apply_batch()
+ */
+typedef enum {
+    ALLOCATOR_OP_REQUEST = 0,        ///< RQ: allocate memory for a process
+    ALLOCATOR_OP_RELEASE,            ///< RL: release a process's memory
+    ALLOCATOR_OP_COMPACT,            ///< C: compact, moving at most size bytes
+    ALLOCATOR_OP_RESIZE              ///< RS: resize a process's memory to size bytes
+} AllocatorOpType;
+
+/* ============================================================================
+ * DATA STRUCTURES
+ * ============================================================================ */
+
+typedef struct Allocator Allocator;  ///< Opaque allocator instance
+typedef uint32_t AllocatorName;      ///< Interned process name (ALLOCATOR_NO_NAME for none)
+
+/**
+ * @struct AllocatorOp
+ * @brief One operation of a batch
+ */
+typedef struct AllocatorOp {
+    AllocatorOpType type;            ///< Request, release or compaction
+    AllocatorName name;              ///< Process the operation applies to (requests and releases)
+    size_t size;                     ///< Bytes to allocate, or most bytes to move (SIZE_MAX for all)
+    AllocationStrategy strategy;     ///< Strategy to allocate with (requests, and resizes that relocate)
+    bool compact_on_fail;            ///< Compact a window and retry if no hole fits (requests only)
+    size_t align;                    ///< Power of two the block must start on, 0 or 1 for any (requests only)
+} AllocatorOp;
+
+/**
+ * @struct AllocatorResult
+ * @brief Outcome of one request or release
+ */
+typedef struct AllocatorResult {
+    AllocatorStatus status;          ///< Whether the operation succeeded, and why not
+    size_t start;                    ///< Start address of the allocated block (successful requests)
+    size_t size;                     ///< Size of the allocated block, at least the bytes requested
+    bool compacted;                  ///< Whether a failed request compacted a window to make room
+    size_t bytes_moved;              ///< Bytes that compaction moved, or that a relocating resize copied
+    bool relocated;                  ///< Whether a resize moved the block rather than resizing it in place
+} AllocatorResult;
+
+/**
+ * @struct AllocatorStats
+ * @brief Summary figures of an allocator's current state
+ */
+typedef struct AllocatorStats {
+    size_t total_size;               ///< Size of the managed memory
+    size_t total_allocated;          ///< Bytes in allocated blocks
+    size_t total_free;               ///< Bytes in holes
+    size_t largest_hole;             ///< Size of the largest hole
+    size_t hole_count;               ///< Number of holes
+    size_t process_count;            ///< Number of processes holding memory
+    size_t internal_waste;           ///< Bytes allocated beyond what processes requested
+    size_t rounding_waste;           ///< Of internal_waste, bytes added by rounding up to a size class
+    size_t request_count;            ///< Valid requests made so far (not duplicates)
+    size_t failed_request_count;     ///< Requests that found no hole, even after compaction
+    size_t block_count;              ///< Blocks (allocated and free) in the list
+    size_t peak_block_count;         ///< Most blocks ever in the list at once
+    double external_fragmentation;   ///< 1 - largest hole / total free, as a percentage
+    size_t searches[ALLOCATOR_STRATEGY_COUNT]; ///< Hole searches made with each strategy
+    size_t probes[ALLOCATOR_STRATEGY_COUNT];   ///< Blocks or index entries those searches examined
+    size_t resize_in_place_count;    ///< Resizes done without moving the block
+    size_t resize_relocated_count;   ///< Resizes that moved the block to a new hole
+    size_t failed_resize_count;      ///< Resizes that found no room, leaving the block as it was
+    size_t resize_bytes_copied;      ///< Bytes the relocating resizes copied
+} AllocatorStats;
+
+/**
+ * @struct AllocatorQuery
+ * @brief Whether a request would be satisfied now, and what it would take if not
+ */
+typedef struct AllocatorQuery {
+    size_t size;                     ///< Bytes the request takes once rounded up to its size class
+    bool fits;                       ///< Whether the strategy would find room now
+    size_t largest_request;          ///< Largest request the strategy could satisfy now, with this alignment
+    size_t largest_hole;             ///< Size of the largest hole
+    size_t total_free;               ///< Bytes in holes
+    size_t hole_count;               ///< Number of holes
+    size_t needed;                   ///< Hole size compaction must gather for the request to fit (SIZE_MAX if none can)
+    size_t align_reserve;            ///< Free bytes compaction may have to leave as padding before aligned blocks
+    bool compaction_fits;            ///< Whether compacting a window is sure to make room
+    bool window_checked;             ///< Whether allocator_query_window() looked for the window
+    size_t bytes_to_move;            ///< At most the bytes the cheapest such window moves (0 unless window_checked finds one)
+} AllocatorQuery;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Create an allocator managing total_size bytes, all initially free
+ *
+ * @param total_size Size of the managed memory (non-zero)
+ * @param index_mode Hole index the allocation strategies should use
+ * @return New allocator, or NULL if total_size is zero or memory ran out
+ */
+Allocator *allocator_create(size_t total_size, HoleIndexMode index_mode);
+
+/**
+ * @brief Free an allocator and everything it holds (NULL is ignored)
+ */
+void allocator_destroy(Allocator *alloc);
+
+/**
+ * @brief Make an independent copy of an allocator, blocks, names and all
+ *
+ * Names interned before the copy have the same AllocatorName in both.
+ *
+ * @return The copy, or NULL if memory ran out
+ */
+Allocator *allocator_clone(const Allocator *alloc);
+
+/**
+ * @brief Make every request compact a window and retry when no hole fits
+ */
+void allocator_set_compact_on_fail(Allocator *alloc, bool enabled);
+
+/**
+ * @brief Round every request up to one of a set of size classes
+ *
+ * A request is given the smallest class that holds it; one larger than
+ * every class is rounded up to a multiple of the largest. The bytes added
+ * count as internal fragmentation and are also reported on their own.
+ * Rounding happens before the strategy looks for a hole, so Buddy (Y)
+ * rounds the class size up again to a power of two.
+ *
+ * @param alloc Allocator that no process holds memory in yet
+ * @param classes Class sizes in increasing order (none zero)
+ * @param count Number of classes (0 to stop rounding, at most
+ *              ALLOCATOR_MAX_SIZE_CLASSES)
+ * @return true on success; false if a process holds memory or the classes
+ *         are invalid, leaving the rounding as it was
+ */
+bool allocator_set_size_classes(Allocator *alloc, const size_t *classes, size_t count);
+
+/**
+ * @brief Check that a string is a usable process name
+ *
+ * @return true if the name is non-empty, shorter than
+ *         ALLOCATOR_MAX_NAME_LENGTH and made of letters, digits and '_'
+ */
+bool allocator_valid_name(const char *name);
+
+/**
+ * @brief Intern a process name, giving the same id every time it is seen
+ *
+ * @return The name's id, or ALLOCATOR_NO_NAME if the name is invalid or
+ *         memory ran out
+ */
+AllocatorName allocator_name(Allocator *alloc, const char *name);
+
+/**
+ * @brief Look up a process name without interning it
+ *
+ * @return The name's id, or ALLOCATOR_NO_NAME if it was never interned
+ */
+AllocatorName allocator_find_name(const Allocator *alloc, const char *name);
+
+/**
+ * @brief String of an interned name ("" for ALLOCATOR_NO_NAME)
+ */
+const char *allocator_name_string(const Allocator *alloc, AllocatorName name);
+
+/**
+ * @brief Whether a process currently holds memory
+ */
+bool allocator_holds_memory(const Allocator *alloc, AllocatorName name);
+
+/**
+ * @brief Allocate memory for a process
+ *
+ * @param alloc Allocator to allocate from
+ * @param name Process that holds no memory yet
+ * @param size Bytes to allocate (non-zero)
+ * @param strategy Allocation strategy to use
+ * @param compact_on_fail Compact the cheapest window and retry if no hole fits
+ * @param result Output (may be NULL): the block allocated and bytes moved
+ * @return ALLOCATOR_OK, or why the request failed
+ */
+AllocatorStatus allocator_request(Allocator *alloc, AllocatorName name, size_t size,
+                                  AllocationStrategy strategy, bool compact_on_fail,
+                                  AllocatorResult *result);
+
+/**
+ * @brief Allocate memory for a process, starting on a multiple of align
+ *
+ * The hole search takes the alignment into account, so a hole is only
+ * chosen if the block fits after its start is rounded up. The bytes
+ * skipped at the front of the hole stay free. Buddy (Y) blocks are
+ * aligned to their own size, so Y allocates at least align bytes. The
+ * block keeps its alignment when it is resized or compacted.
+ *
+ * @param alloc Allocator to allocate from
+ * @param name Process that holds no memory yet
+ * @param size Bytes to allocate (non-zero)
+ * @param align Power of two the start address must be a multiple of
+ * @param strategy Allocation strategy to use
+ * @param compact_on_fail Compact the cheapest window and retry if no hole fits
+ * @param result Output (may be NULL): the block allocated and bytes moved
+ * @return ALLOCATOR_OK, or why the request failed (ALLOCATOR_INVALID if
+ *         align is not a power of two)
+ */
+AllocatorStatus allocator_request_aligned(Allocator *alloc, AllocatorName name, size_t size, size_t align,
+                                          AllocationStrategy strategy, bool compact_on_fail,
+                                          AllocatorResult *result);
+
+/**
+ * @brief Find out whether a request would be satisfied, without making it
+ *
+ * The largest hole and the largest request that would fit are read from
+ * the hole indexes. Compaction is reported as sure to make room when the
+ * free memory covers the required hole plus the padding every aligned
+ * block may keep, which takes no scan; allocator_query_window() finds
+ * the window itself.
+ *
+ * @param alloc Allocator to query
+ * @param size Bytes to allocate (non-zero)
+ * @param align Power of two the start address must be a multiple of
+ * @param strategy Allocation strategy the request would use
+ * @param query Output: the findings
+ * @return ALLOCATOR_OK, or ALLOCATOR_INVALID for a zero size, an alignment
+ *         that is not a power of two, or an unknown strategy
+ */
+AllocatorStatus allocator_query(Allocator *alloc, size_t size, size_t align, AllocationStrategy strategy,
+                                AllocatorQuery *query);
+
+/**
+ * @brief Find the window compaction would slide for a query that does not fit
+ *
+ * Scans the block list for the cheapest window, the same one
+ * --compact-on-fail would slide, and sets bytes_to_move. Since the window
+ * decides the matter, compaction_fits then says exactly whether one
+ * exists. This is O(n), so traces leave it out of failed requests; QUERY
+ * and requests typed at the prompt ask for it. bytes_to_move is an upper
+ * bound: blocks that already keep their alignment may not need to move.
+ *
+ * @param alloc Allocator the query was made on, unchanged since
+ * @param query Findings of allocator_query(), updated in place
+ */
+void allocator_query_window(Allocator *alloc, AllocatorQuery *query);
+
+/**
+ * @brief Release a process's memory, merging it with neighbouring holes
+ *
+ * @return ALLOCATOR_OK, or ALLOCATOR_NOT_FOUND if the process holds none
+ */
+AllocatorStatus allocator_release(Allocator *alloc, AllocatorName name);
+
+/**
+ * @brief Resize a process's memory, keeping its contents
+ *
+ * Shrinking returns the tail of the block as a hole. Growing extends the
+ * block into the hole that follows it if that is large enough, and
+ * otherwise moves it to a new block allocated with the given strategy.
+ * The resized block is exactly new_size bytes, or new_size rounded up to
+ * its size class, and keeps the alignment it was requested with.
+ *
+ * @param alloc Allocator the process's memory belongs to
+ * @param name Process that holds memory
+ * @param new_size New size in bytes (non-zero)
+ * @param strategy Allocation strategy used if the block has to move
+ * @param result Output (may be NULL): the block now held, whether it
+ *               moved, and the bytes copied if it did
+ * @return ALLOCATOR_OK; ALLOCATOR_NOT_FOUND if the process holds no
+ *         memory; ALLOCATOR_NO_SPACE if no hole fits, keeping the old block
+ */
+AllocatorStatus allocator_resize(Allocator *alloc, AllocatorName name, size_t new_size,
+                                 AllocationStrategy strategy, AllocatorResult *result);
+
+/**
+ * @brief Slide allocated blocks towards address 0 to merge the holes
+ *
+ * @param max_bytes_moved Most bytes to move (SIZE_MAX for a full compaction)
+ * @return Number of bytes moved
+ */
+size_t allocator_compact(Allocator *alloc, size_t max_bytes_moved);
+
+/**
+ * @brief Apply a sequence of requests, releases, resizes and compactions in order
+ *
+ * A failed operation does not stop the batch; its status is recorded and
+ * the next operation is applied.
+ *
+ * @param alloc Allocator to apply the operations to
+ * @param ops Operations to apply
+ * @param count Number of operations
+ * @param results Output: one result per operation
+ * @return Number of operations that succeeded
+ */
+size_t allocator_apply_batch(Allocator *alloc, const AllocatorOp *ops, size_t count,
+                             AllocatorResult *results);
+
+/**
+ * @brief Write the allocator's whole state to a snapshot file
+ *
+ * The file holds the block list and name table as flat arrays linked by
+ * index, so allocator_load() can map it back in place.
+ *
+ * @return true on success, false if the file could not be written
+ */
+bool allocator_save(const Allocator *alloc, const char *path);
+
+/**
+ * @brief Replace the allocator's state with a snapshot written by allocator_save()
+ *
+ * The file is mapped copy-on-write rather than read, so loading takes
+ * no per-block work; changes made afterwards never reach the file.
+ * Snapshots can only be loaded by a build with the same data layout.
+ *
+ * @return true on success; false if the file cannot be read or is not a
+ *         snapshot, leaving the allocator as it was
+ */
+bool allocator_load(Allocator *alloc, const char *path);
+
+/**
+ * @brief Fill in summary figures of the allocator's current state
+ *
+ * The figures are kept up to date on every operation, so this takes
+ * constant time and does not walk the block list.
+ */
+void allocator_get_stats(Allocator *alloc, AllocatorStats *stats);
+
+/**
+ * @brief Write the STAT report: allocated blocks, holes and summary
+ *
+ * @param alloc Allocator to report on
+ * @param out Stream to write to
+ * @param flags ALLOCATOR_STAT_* flags (0 for the plain STAT report)
+ */
+void allocator_print_statistics(Allocator *alloc, FILE *out, unsigned flags);
+
+/**
+ * @brief Write the STAT block listing for the blocks overlapping [from, to)
+ *
+ * Sizes and addresses are written exactly, in the largest unit that
+ * divides them. A range that does not start at 0 is located through an
+ * index of the allocated blocks, built on the first such call, so the
+ * cost depends on the blocks listed rather than on where they lie.
+ *
+ * @param alloc Allocator to list
+ * @param out Stream to write to
+ * @param from Start of the range
+ * @param to End of the range (clipped to the memory size); an empty range
+ *           lists the whole memory
+ */
+void allocator_print_blocks(Allocator *alloc, FILE *out, size_t from, size_t to);
+
+/**
+ * @brief Write the memory map of [from, to) in width columns (STAT -v)
+ *
+ * A column shows '#' if its range is wholly allocated, '.' if wholly free
+ * and '+' if mixed. The first call builds a summary of free bytes per
+ * region, which is kept up to date from then on, so the map takes
+ * O(width log n) at any zoom level.
+ *
+ * @param alloc Allocator to draw
+ * @param out Stream to write to
+ * @param width Number of columns (0 for ALLOCATOR_MAP_WIDTH; at most to - from)
+ * @param from Start of the range to show
+ * @param to End of the range (clipped to the memory size); an empty range
+ *           shows the whole memory
+ */
+void allocator_print_map(Allocator *alloc, FILE *out, size_t width, size_t from, size_t to);
+
+/**
+ * @brief Short description of a status, for error messages
+ */
+const char *allocator_status_string(AllocatorStatus status);
+
+#endif /* ALLOCATOR_H */
@@ -0,0 +1,610 @@
+/**
+ * @file arena.c
+ * @brief Thread-safe allocator made of independently locked arenas
+ * 
+ * Each arena is a plain Allocator covering its own slice of the address
+ * range, guarded by its own mutex (lock striping by address range). The
+ * Allocator code itself is unchanged: it keeps no global state, so
+ * separate instances can run on separate threads as long as each one is
+ * only touched under its lock.
+ * 
+ * Threads are given home arenas round-robin on their first call, which
+ * spreads up to arena_count threads over distinct locks. A request that
+ * its home arena cannot satisfy walks the other arenas in order, taking
+ * one lock at a time, so no thread ever holds two arena locks.
+ * 
+ * With the thread cache enabled, small requests are rounded up to a
+ * power-of-two size class and served from a per-thread stack of blocks
+ * of that class. The stacks are refilled from the arenas, and flushed
+ * back to them, ARENA_CACHE_BATCH blocks under a single lock, so the
+ * common request and release take no lock and never touch a block list.
+ * Cached blocks are held in their arena under reserved "__cache" names.
+ * 
+ * @author Gabriel Giancarlo
+ * @date 2025
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+
+/* ============================================================================
+ * CONSTANTS AND MACROS
+ * ============================================================================ */
+
+#define ARENA_CACHE_LINE 64          ///< Arenas are padded to this so their locks never share a line
+#define ARENA_CACHE_MIN_SHIFT 4      ///< Smallest size class is 16 bytes
+#define ARENA_CACHE_CLASS_COUNT 9    ///< Size classes 16, 32, ..., ARENA_CACHE_MAX_SIZE bytes
+#define ARENA_CACHE_DEPTH 32         ///< Blocks a thread caches per size class
+#define ARENA_CACHE_BATCH 8          ///< Blocks moved per refill or flush
+#define ARENA_RESERVED_PREFIX "__"   ///< Names starting with this belong to the cache
+
+/* ============================================================================
+ * DATA STRUCTURES
+ * ============================================================================ */
+
+/**
+ * @struct Arena
+ * @brief One independently locked slice of the address range
+ */
+typedef struct Arena {
+    pthread_mutex_t lock;            ///< Guards everything below
+    Allocator *alloc;                ///< Allocator over [base, base + size)
+    size_t base;                     ///< First address of the slice
+    size_t granted_count;            ///< Requests satisfied here
+    size_t steal_count;              ///< Of those, requests from threads whose home is another arena
+    size_t failed_count;             ///< Requests from threads at home here that no arena satisfied
+    AllocatorName *spare_names;      ///< Cache names not holding a block, for reuse
+    size_t spare_count;              ///< Entries in spare_names
+    size_t spare_capacity;           ///< Slots allocated in spare_names
+    unsigned cache_name_count;       ///< Cache names interned so far
+} Arena;
+
+/**
+ * @union ArenaSlot
+ * @brief An Arena padded to a whole number of cache lines
+ */
+typedef union ArenaSlot {
+    Arena arena;
+    char pad[((sizeof(Arena) + ARENA_CACHE_LINE - 1) / ARENA_CACHE_LINE) * ARENA_CACHE_LINE];
+} ArenaSlot;
+
+/**
+ * @struct CacheClass
+ * @brief Free blocks of one size class held by a thread
+ */
+typedef struct CacheClass {
+    size_t count;                    ///< Blocks on the stack
+    ArenaBlock blocks[ARENA_CACHE_DEPTH]; ///< Stack of blocks, top at count - 1
+} CacheClass;
+
+/**
+ * @struct ThreadCache
+ * @brief Per-thread state: the home arena and the size-class stacks
+ */
+typedef struct ThreadCache {
+    ArenaAllocator *owner;           ///< Allocator the cache belongs to
+    unsigned home;                   ///< Home arena of the thread
+    struct ThreadCache *prev;        ///< Previous cache of the owner (guarded by home_lock)
+    struct ThreadCache *next;        ///< Next cache of the owner (guarded by home_lock)
+    size_t hits;                     ///< Requests served from a stack (written by its thread only)
+    size_t misses;                   ///< Requests that found their stack empty
+    CacheClass classes[ARENA_CACHE_CLASS_COUNT]; ///< One stack per size class
+} ThreadCache;
+
+/**
+ * @struct ArenaAllocator
+ * @brief A set of arenas and the thread-to-arena assignment
+ */
+struct ArenaAllocator {
+    ArenaSlot *slots;                ///< arena_count arenas, in address order
+    unsigned arena_count;            ///< Number of arenas
+    size_t total_size;               ///< Size of the managed memory
+    bool thread_cache;               ///< Whether small requests go through the thread caches
+    pthread_key_t cache_key;         ///< The calling thread's ThreadCache
+    pthread_mutex_t home_lock;       ///< Guards everything below
+    unsigned next_home;              ///< Home arena of the next new thread
+    ThreadCache *caches;             ///< Every live thread's cache
+    size_t retired_hits;             ///< Cache hits of threads that have exited
+    size_t retired_misses;           ///< Cache misses of threads that have exited
+};
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS
+ * ============================================================================ */
+
+// Arena access
+static AllocatorStatus arena_try_request(Arena *arena, const char *name, size_t size,
+                                         AllocationStrategy strategy, bool stolen, ArenaBlock *block);
+static AllocatorName arena_cache_name(Arena *arena);
+static void arena_spare_name(Arena *arena, AllocatorName name);
+
+// Thread caches
+static ThreadCache *thread_cache(ArenaAllocator *arenas);
+static void thread_cache_exit(void *value);
+static int cache_class(size_t size);
+static size_t cache_refill(ArenaAllocator *arenas, ThreadCache *cache, int size_class, AllocationStrategy strategy);
+static void cache_flush(ArenaAllocator *arenas, CacheClass *stack, size_t count);
+
+/* ============================================================================
+ * ARENA ACCESS
+ * ============================================================================ */
+
+/**
+ * @brief Request memory from a single arena under its lock
+ * 
+ * @param arena Arena to allocate from
+ * @param name Process name
+ * @param size Bytes to allocate
+ * @param strategy Allocation strategy
+ * @param stolen Whether this is not the calling thread's home arena
+ * @param block Output: block allocated (arena index is left to the caller)
+ * @return Status of the request
+ */
+static AllocatorStatus arena_try_request(Arena *arena, const char *name, size_t size,
+                                         AllocationStrategy strategy, bool stolen, ArenaBlock *block) {
+    AllocatorResult result;
+    pthread_mutex_lock(&arena->lock);
+    AllocatorName id = allocator_name(arena->alloc, name);
+    AllocatorStatus status = (id == ALLOCATOR_NO_NAME) ? ALLOCATOR_INVALID
+                             : allocator_request(arena->alloc, id, size, strategy, false, &result);
+    if (status == ALLOCATOR_OK) {
+        arena->granted_count++;
+        arena->steal_count += stolen;
+    }
+    pthread_mutex_unlock(&arena->lock);
+    
+    if (status == ALLOCATOR_OK) {
+        block->name = id;
+        block->start = arena->base + result.start;
+        block->size = result.size;
+        block->cached = false;
+    }
+    return status;
+}
+
+/**
+ * @brief Name for a block about to be cached (arena lock held)
+ * 
+ * Names of flushed blocks are reused, so an arena never interns more
+ * cache names than it has had cached blocks at once.
+ * 
+ * @param arena Arena the block will come from
+ * @return Name id, or ALLOCATOR_NO_NAME if memory ran out
+ */
+static AllocatorName arena_cache_name(Arena *arena) {
+    if (arena->spare_count > 0) {
+        return arena->spare_names[--arena->spare_count];
+    }
+    char name[ALLOCATOR_MAX_NAME_LENGTH];
+    snprintf(name, sizeof(name), ARENA_RESERVED_PREFIX "cache%u", arena->cache_name_count);
+    AllocatorName id = allocator_name(arena->alloc, name);
+    if (id != ALLOCATOR_NO_NAME) {
+        arena->cache_name_count++;
+    }
+    return id;
+}
+
+/**
+ * @brief Keep a cache name that no longer holds a block (arena lock held)
+ * 
+ * If the spare list cannot grow the name is simply not reused.
+ * 
+ * @param arena Arena the name belongs to
+ * @param name Name to keep
+ */
+static void arena_spare_name(Arena *arena, AllocatorName name) {
+    if (arena->spare_count == arena->spare_capacity) {
+        size_t capacity = (arena->spare_capacity == 0) ? ARENA_CACHE_DEPTH : 2 * arena->spare_capacity;
+        AllocatorName *grown = (AllocatorName *)realloc(arena->spare_names, capacity * sizeof(AllocatorName));
+        if (grown == NULL) {
+            return;
+        }
+        arena->spare_names = grown;
+        arena->spare_capacity = capacity;
+    }
+    arena->spare_names[arena->spare_count++] = name;
+}
+
+/* ============================================================================
+ * THREAD CACHES
+ * ============================================================================ */
+
+/**
+ * @brief The calling thread's cache, created on its first call
+ * 
+ * Creating the cache assigns the thread's home arena, round-robin.
+ * 
+ * @param arenas Allocator the cache belongs to
+ * @return The cache, or NULL if memory ran out
+ */
+static ThreadCache *thread_cache(ArenaAllocator *arenas) {
+    ThreadCache *cache = (ThreadCache *)pthread_getspecific(arenas->cache_key);
+    if (cache != NULL) {
+        return cache;
+    }
+    cache = (ThreadCache *)calloc(1, sizeof(ThreadCache));
+    if (cache == NULL) {
+        return NULL;
+    }
+    cache->owner = arenas;
+    
+    pthread_mutex_lock(&arenas->home_lock);
+    cache->home = arenas->next_home;
+    arenas->next_home = (cache->home + 1) % arenas->arena_count;
+    cache->next = arenas->caches;
+    if (arenas->caches != NULL) {
+        arenas->caches->prev = cache;
+    }
+    arenas->caches = cache;
+    pthread_mutex_unlock(&arenas->home_lock);
+    
+    pthread_setspecific(arenas->cache_key, cache);
+    return cache;
+}
+
+/**
+ * @brief Return a finished thread's cached blocks and free its cache
+ * 
+ * Runs as the destructor of cache_key when a thread exits. Its hit and
+ * miss counts are kept in the allocator's totals.
+ * 
+ * @param value The thread's ThreadCache
+ */
+static void thread_cache_exit(void *value) {
+    ThreadCache *cache = (ThreadCache *)value;
+    ArenaAllocator *arenas = cache->owner;
+    for (int i = 0; i < ARENA_CACHE_CLASS_COUNT; i++) {
+        cache_flush(arenas, &cache->classes[i], cache->classes[i].count);
+    }
+    
+    pthread_mutex_lock(&arenas->home_lock);
+    if (cache->prev != NULL) {
+        cache->prev->next = cache->next;
+    } else {
+        arenas->caches = cache->next;
+    }
+    if (cache->next != NULL) {
+        cache->next->prev = cache->prev;
+    }
+    arenas->retired_hits += cache->hits;
+    arenas->retired_misses += cache->misses;
+    pthread_mutex_unlock(&arenas->home_lock);
+    free(cache);
+}
+
+/**
+ * @brief Size class of a request
+ * 
+ * @param size Bytes requested
+ * @return Class k, holding blocks of 16 << k bytes, or -1 if too large to cache
+ */
+static int cache_class(size_t size) {
+    if (size > ARENA_CACHE_MAX_SIZE) {
+        return -1;
+    }
+    if (size <= ((size_t)1 << ARENA_CACHE_MIN_SHIFT)) {
+        return 0;
+    }
+    return (int)(sizeof(unsigned long long) * CHAR_BIT) - __builtin_clzll((unsigned long long)size - 1)
+           - ARENA_CACHE_MIN_SHIFT;
+}
+
+/**
+ * @brief Fill an empty size-class stack with up to ARENA_CACHE_BATCH blocks
+ * 
+ * Blocks are taken from the home arena under one lock. If it has none
+ * to give, the other arenas are tried in turn until one does.
+ * 
+ * @param arenas Allocator to take the blocks from
+ * @param cache Calling thread's cache
+ * @param size_class Class of the stack to fill
+ * @param strategy Allocation strategy within the arena
+ * @return Number of blocks added
+ */
+static size_t cache_refill(ArenaAllocator *arenas, ThreadCache *cache, int size_class, AllocationStrategy strategy) {
+    CacheClass *stack = &cache->classes[size_class];
+    size_t class_size = (size_t)1 << (size_class + ARENA_CACHE_MIN_SHIFT);
+    
+    for (unsigned tried = 0; tried < arenas->arena_count && stack->count == 0; tried++) {
+        unsigned index = (cache->home + tried) % arenas->arena_count;
+        Arena *arena = &arenas->slots[index].arena;
+        
+        pthread_mutex_lock(&arena->lock);
+        while (stack->count < ARENA_CACHE_BATCH) {
+            AllocatorName name = arena_cache_name(arena);
+            AllocatorResult result;
+            if (name == ALLOCATOR_NO_NAME) {
+                break;
+            }
+            if (allocator_request(arena->alloc, name, class_size, strategy, false, &result) != ALLOCATOR_OK) {
+                arena_spare_name(arena, name);
+                break;
+            }
+            stack->blocks[stack->count++] = (ArenaBlock){index, name, arena->base + result.start,
+                                                         result.size, true};
+            arena->granted_count++;
+            arena->steal_count += (tried > 0);
+        }
+        pthread_mutex_unlock(&arena->lock);
+    }
+    return stack->count;
+}
+
+/**
+ * @brief Release the top blocks of a size-class stack to their arenas
+ * 
+ * Consecutive blocks from the same arena are released under one lock.
+ * 
+ * @param arenas Allocator the blocks came from
+ * @param stack Stack to take the blocks from
+ * @param count Number of blocks to release (at most stack->count)
+ */
+static void cache_flush(ArenaAllocator *arenas, CacheClass *stack, size_t count) {
+    Arena *locked = NULL;
+    for (size_t i = 0; i < count; i++) {
+        const ArenaBlock *block = &stack->blocks[--stack->count];
+        Arena *arena = &arenas->slots[block->arena].arena;
+        if (arena != locked) {
+            if (locked != NULL) {
+                pthread_mutex_unlock(&locked->lock);
+            }
+            pthread_mutex_lock(&arena->lock);
+            locked = arena;
+        }
+        if (allocator_release(arena->alloc, block->name) == ALLOCATOR_OK) {
+            arena_spare_name(arena, block->name);
+        }
+    }
+    if (locked != NULL) {
+        pthread_mutex_unlock(&locked->lock);
+    }
+}
+
+/* ============================================================================
+ * PUBLIC INTERFACE
+ * ============================================================================ */
+
+/**
+ * @brief Create an allocator of equal arenas
+ * 
+ * The last arena also takes the bytes left over when total_size does not
+ * divide evenly. The thread cache starts disabled.
+ * 
+ * @param total_size Size of the managed memory
+ * @param arena_count Number of arenas (1 to ARENA_MAX_COUNT)
+ * @param index_mode Hole index of every arena
+ * @return New allocator, or NULL on invalid arguments or if resources ran out
+ */
+ArenaAllocator *arena_allocator_create(size_t total_size, unsigned arena_count, HoleIndexMode index_mode) {
+    if (arena_count == 0 || arena_count > ARENA_MAX_COUNT || total_size < arena_count) {
+        return NULL;
+    }
+    ArenaAllocator *arenas = (ArenaAllocator *)calloc(1, sizeof(ArenaAllocator));
+    if (arenas == NULL) {
+        return NULL;
+    }
+    void *slots = NULL;
+    if (posix_memalign(&slots, ARENA_CACHE_LINE, arena_count * sizeof(ArenaSlot)) != 0) {
+        free(arenas);
+        return NULL;
+    }
+    memset(slots, 0, arena_count * sizeof(ArenaSlot));
+    arenas->slots = (ArenaSlot *)slots;
+    arenas->total_size = total_size;
+    
+    if (pthread_key_create(&arenas->cache_key, thread_cache_exit) != 0) {
+        free(arenas->slots);
+        free(arenas);
+        return NULL;
+    }
+    pthread_mutex_init(&arenas->home_lock, NULL);
+    
+    // Carve the address range; arena_count counts the arenas built so far
+    size_t share = total_size / arena_count;
+    for (unsigned i = 0; i < arena_count; i++) {
+        Arena *arena = &arenas->slots[i].arena;
+        size_t size = (i == arena_count - 1) ? total_size - share * i : share;
+        arena->base = share * i;
+        arena->alloc = allocator_create(size, index_mode);
+        if (arena->alloc == NULL) {
+            arena_allocator_destroy(arenas);
+            return NULL;
+        }
+        pthread_mutex_init(&arena->lock, NULL);
+        arenas->arena_count = i + 1;
+    }
+    return arenas;
+}
+
+/**
+ * @brief Free an ArenaAllocator, its arenas and every thread's cache
+ * 
+ * Deleting the key first means the caches' destructors will not run
+ * when their threads exit later.
+ * 
+ * @param arenas Allocator to free (NULL is ignored)
+ */
+void arena_allocator_destroy(ArenaAllocator *arenas) {
+    if (arenas == NULL) {
+        return;
+    }
+    pthread_key_delete(arenas->cache_key);
+    while (arenas->caches != NULL) {
+        ThreadCache *next = arenas->caches->next;
+        free(arenas->caches);
+        arenas->caches = next;
+    }
+    for (unsigned i = 0; i < arenas->arena_count; i++) {
+        pthread_mutex_destroy(&arenas->slots[i].arena.lock);
+        allocator_destroy(arenas->slots[i].arena.alloc);
+        free(arenas->slots[i].arena.spare_names);
+    }
+    pthread_mutex_destroy(&arenas->home_lock);
+    free(arenas->slots);
+    free(arenas);
+}
+
+/**
+ * @brief Serve small requests from per-thread caches
+ * 
+ * @param arenas Allocator to configure
+ * @param enabled Whether to use the thread caches
+ */
+void arena_allocator_set_thread_cache(ArenaAllocator *arenas, bool enabled) {
+    arenas->thread_cache = enabled;
+}
+
+/**
+ * @brief Home arena of the calling thread
+ * 
+ * @param arenas Allocator to look up
+ * @return Arena index, assigned round-robin on the thread's first call
+ *         (arena 0 if the thread's cache could not be created)
+ */
+unsigned arena_allocator_home(ArenaAllocator *arenas) {
+    ThreadCache *cache = thread_cache(arenas);
+    return (cache != NULL) ? cache->home : 0;
+}
+
+/**
+ * @brief Allocate memory for a process in the caller's arena, or steal
+ * 
+ * With the thread cache enabled, a request of up to ARENA_CACHE_MAX_SIZE
+ * bytes pops a block of its size class off the thread's stack, refilling
+ * the stack first if it is empty. Otherwise the home arena is tried
+ * first, and only when it has no hole large enough are the following
+ * arenas tried, one at a time, wrapping around.
+ * 
+ * @param arenas Allocator to allocate from
+ * @param name Process name
+ * @param size Bytes to allocate (non-zero)
+ * @param strategy Allocation strategy within each arena
+ * @param block Output: where the memory was allocated
+ * @return ALLOCATOR_OK, or why the request failed
+ */
+AllocatorStatus arena_allocator_request(ArenaAllocator *arenas, const char *name, size_t size,
+                                        AllocationStrategy strategy, ArenaBlock *block) {
+    if (size == 0 || !allocator_valid_name(name) ||
+        strncmp(name, ARENA_RESERVED_PREFIX, strlen(ARENA_RESERVED_PREFIX)) == 0) {
+        return ALLOCATOR_INVALID;
+    }
+    ThreadCache *cache = thread_cache(arenas);
+    unsigned home = (cache != NULL) ? cache->home : 0;
+    
+    int size_class = cache_class(size);
+    if (arenas->thread_cache && cache != NULL && size_class >= 0) {
+        CacheClass *stack = &cache->classes[size_class];
+        if (stack->count > 0) {
+            __atomic_store_n(&cache->hits, cache->hits + 1, __ATOMIC_RELAXED);
+        } else {
+            __atomic_store_n(&cache->misses, cache->misses + 1, __ATOMIC_RELAXED);
+            cache_refill(arenas, cache, size_class, strategy);
+        }
+        if (stack->count > 0) {
+            *block = stack->blocks[--stack->count];
+            return ALLOCATOR_OK;
+        }
+        // No arena has room for a whole class-sized block; an exact-size one may still fit
+    }
+    
+    AllocatorStatus status = ALLOCATOR_NO_SPACE;
+    for (unsigned tried = 0; tried < arenas->arena_count && status == ALLOCATOR_NO_SPACE; tried++) {
+        unsigned index = (home + tried) % arenas->arena_count;
+        Arena *arena = &arenas->slots[index].arena;
+        status = arena_try_request(arena, name, size, strategy, tried > 0, block);
+        if (status == ALLOCATOR_OK) {
+            block->arena = index;
+        }
+    }
+    
+    if (status == ALLOCATOR_NO_SPACE) {
+        Arena *arena = &arenas->slots[home].arena;
+        pthread_mutex_lock(&arena->lock);
+        arena->failed_count++;
+        pthread_mutex_unlock(&arena->lock);
+    }
+    return status;
+}
+
+/**
+ * @brief Release a block returned by arena_allocator_request()
+ * 
+ * A cached block goes back on the calling thread's stack for its class;
+ * a full stack first flushes ARENA_CACHE_BATCH blocks to their arenas.
+ * 
+ * @param arenas Allocator the block came from
+ * @param block Block to release
+ * @return ALLOCATOR_OK, or ALLOCATOR_NOT_FOUND if the block is not held
+ */
+AllocatorStatus arena_allocator_release(ArenaAllocator *arenas, const ArenaBlock *block) {
+    if (block->arena >= arenas->arena_count) {
+        return ALLOCATOR_NOT_FOUND;
+    }
+    
+    ThreadCache *cache = block->cached ? thread_cache(arenas) : NULL;
+    if (cache != NULL) {
+        CacheClass *stack = &cache->classes[cache_class(block->size)];
+        if (stack->count == ARENA_CACHE_DEPTH) {
+            cache_flush(arenas, stack, ARENA_CACHE_BATCH);
+        }
+        stack->blocks[stack->count++] = *block;
+        return ALLOCATOR_OK;
+    }
+    
+    Arena *arena = &arenas->slots[block->arena].arena;
+    pthread_mutex_lock(&arena->lock);
+    AllocatorStatus status = allocator_release(arena->alloc, block->name);
+    if (status == ALLOCATOR_OK && block->cached) {
+        arena_spare_name(arena, block->name);
+    }
+    pthread_mutex_unlock(&arena->lock);
+    return status;
+}
+
+/**
+ * @brief Sum the figures of every arena and thread cache
+ * 
+ * The arenas are locked one after another, so with other threads running
+ * the totals are not a single consistent snapshot. Blocks sitting in a
+ * thread cache count as allocated.
+ * 
+ * @param arenas Allocator to report on
+ * @param stats Output figures
+ */
+void arena_allocator_get_stats(ArenaAllocator *arenas, ArenaStats *stats) {
+    memset(stats, 0, sizeof(ArenaStats));
+    stats->arena_count = arenas->arena_count;
+    stats->total_size = arenas->total_size;
+    
+    for (unsigned i = 0; i < arenas->arena_count; i++) {
+        Arena *arena = &arenas->slots[i].arena;
+        AllocatorStats part;
+        pthread_mutex_lock(&arena->lock);
+        allocator_get_stats(arena->alloc, &part);
+        stats->request_count += arena->granted_count + arena->failed_count;
+        stats->failed_request_count += arena->failed_count;
+        stats->steal_count += arena->steal_count;
+        pthread_mutex_unlock(&arena->lock);
+        
+        stats->total_allocated += part.total_allocated;
+        stats->total_free += part.total_free;
+        if (part.largest_hole > stats->largest_hole) {
+            stats->largest_hole = part.largest_hole;
+        }
+    }
+    
+    pthread_mutex_lock(&arenas->home_lock);
+    stats->cache_hits = arenas->retired_hits;
+    stats->cache_misses = arenas->retired_misses;
+    for (ThreadCache *cache = arenas->caches; cache != NULL; cache = cache->next) {
+        stats->cache_hits += __atomic_load_n(&cache->hits, __ATOMIC_RELAXED);
+        stats->cache_misses += __atomic_load_n(&cache->misses, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&arenas->home_lock);
+}
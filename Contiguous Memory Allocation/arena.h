@@ -0,0 +1,134 @@
+/**
+ * @file arena.h
+ * @brief Thread-safe allocator made of independently locked arenas
+ *
+ * An ArenaAllocator splits [0, total_size) into a number of contiguous
+ * arenas, each an Allocator with its own lock and block list. A thread
+ * is assigned a home arena the first time it calls in, and requests go
+ * to that arena; when it has no hole large enough, the other arenas are
+ * tried in turn (stealing). Threads working in different arenas never
+ * contend for the same lock.
+ *
+ * A request returns an ArenaBlock recording which arena holds the
+ * memory, and the block is released through that handle, so no lookup
+ * across arenas is needed. Process names are interned per arena and are
+ * only checked for duplicates within the arena that is tried.
+ *
+ * Optionally, requests of up to ARENA_CACHE_MAX_SIZE bytes are rounded up
+ * to a power-of-two size class and served from a per-thread cache of
+ * free blocks, which takes no lock in the common case. Such blocks are
+ * not registered under the process name, so they are not checked for
+ * duplicates, and a cached block released twice is not detected.
+ *
+ * @author Gabriel Giancarlo
+ * @date 2025
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "allocator.h"
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+#define ARENA_MAX_COUNT 64           ///< Most arenas an ArenaAllocator can have
+#define ARENA_CACHE_MAX_SIZE 4096    ///< Largest request the thread cache serves
+
+/* ============================================================================
+ * DATA STRUCTURES
+ * ============================================================================ */
+
+typedef struct ArenaAllocator ArenaAllocator; ///< Opaque multi-arena instance
+
+/**
+ * @struct ArenaBlock
+ * @brief Memory handed out by an ArenaAllocator
+ */
+typedef struct ArenaBlock {
+    unsigned arena;                  ///< Arena holding the block
+    AllocatorName name;              ///< Process name as interned by that arena
+    size_t start;                    ///< Start address within [0, total_size)
+    size_t size;                     ///< Size of the block, at least the bytes requested
+    bool cached;                     ///< Whether the block belongs to the thread cache
+} ArenaBlock;
+
+/**
+ * @struct ArenaStats
+ * @brief Summary figures of an ArenaAllocator, summed over its arenas
+ */
+typedef struct ArenaStats {
+    unsigned arena_count;            ///< Number of arenas
+    size_t total_size;               ///< Size of the managed memory
+    size_t total_allocated;          ///< Bytes in allocated blocks
+    size_t total_free;               ///< Bytes in holes
+    size_t largest_hole;             ///< Size of the largest hole in any arena
+    size_t request_count;            ///< Requests that reached an arena (duplicates and invalid names excluded)
+    size_t failed_request_count;     ///< Requests no arena could satisfy
+    size_t steal_count;              ///< Requests satisfied by an arena other than the caller's
+    size_t cache_hits;               ///< Small requests served from a thread cache
+    size_t cache_misses;             ///< Small requests that had to refill a thread cache first
+} ArenaStats;
+
+/* ============================================================================
+ * FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Create an allocator of arena_count equal arenas over total_size bytes
+ *
+ * @param total_size Size of the managed memory
+ * @param arena_count Number of arenas (1 to ARENA_MAX_COUNT, and each
+ *                    arena must get at least one byte)
+ * @param index_mode Hole index every arena should use
+ * @return New allocator, or NULL on invalid arguments or if resources ran out
+ */
+ArenaAllocator *arena_allocator_create(size_t total_size, unsigned arena_count, HoleIndexMode index_mode);
+
+/**
+ * @brief Free an ArenaAllocator (NULL is ignored)
+ *
+ * No other thread may be using it.
+ */
+void arena_allocator_destroy(ArenaAllocator *arenas);
+
+/**
+ * @brief Serve small requests from per-thread caches
+ *
+ * Call before any thread makes a request. Off by default.
+ */
+void arena_allocator_set_thread_cache(ArenaAllocator *arenas, bool enabled);
+
+/**
+ * @brief Home arena of the calling thread, assigning one on first use
+ */
+unsigned arena_allocator_home(ArenaAllocator *arenas);
+
+/**
+ * @brief Allocate memory for a process, stealing from other arenas if needed
+ *
+ * @param arenas Allocator to allocate from
+ * @param name Process name (see allocator_valid_name()); names starting
+ *             with "__" are reserved
+ * @param size Bytes to allocate (non-zero)
+ * @param strategy Allocation strategy used within each arena
+ * @param block Output: where the memory was allocated
+ * @return ALLOCATOR_OK, or why the request failed
+ */
+AllocatorStatus arena_allocator_request(ArenaAllocator *arenas, const char *name, size_t size,
+                                        AllocationStrategy strategy, ArenaBlock *block);
+
+/**
+ * @brief Release a block returned by arena_allocator_request()
+ *
+ * @return ALLOCATOR_OK, or ALLOCATOR_NOT_FOUND if the block is not held
+ */
+AllocatorStatus arena_allocator_release(ArenaAllocator *arenas, const ArenaBlock *block);
+
+/**
+ * @brief Fill in summary figures, locking each arena in turn
+ */
+void arena_allocator_get_stats(ArenaAllocator *arenas, ArenaStats *stats);
+
+#endif /* ARENA_H */
@@ -0,0 +1,2202 @@
+/**
+ * @file repl.c
+ * @brief Command-line front end of the Contiguous Memory Allocator
+ * 
+ * Reads commands from stdin (or a trace file) and carries them out with
+ * the allocator library declared in allocator.h. Commands:
+ * - RQ <process> <size> <F|B|W|Y|T|N>: Request memory
+ * - RL <process>: Release memory
+ * - RS <process> <new_size> [F|B|W|Y|T|N]: Resize memory, in place if possible
+ * - C [max_bytes_moved]: Compact memory
+ * - STAT [-s] [-t] [-v [width] [from-to]]: Print statistics
+ * - SIM [-b] <file> [--sample=N]: Run a text or binary trace
+ * - SIM --compare <file>: Run a text trace under every strategy at once
+ * - SAVE <file>, LOAD <file>: Write the whole state to a snapshot, or map one back
+ * - X: Exit
+ * 
+ * The same binary converts text traces to binary ones (--convert),
+ * benchmarks the strategies (--bench) and measures how the arena
+ * allocator of arena.h scales with threads (--bench-threads).
+ * 
+ * @author Gabriel Giancarlo
+ * @date 2025
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "allocator.h"
+#include "arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <limits.h>
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* ============================================================================
+ * CONSTANTS AND MACROS
+ * ============================================================================ */
+
+#define MAX_LINE_LENGTH 4096         ///< Longest command or trace line, with its NUL
+#define MAX_PROCESS_NAME_LENGTH ALLOCATOR_MAX_NAME_LENGTH
+#define TRACE_MAGIC "CMATRACE"       ///< First 8 bytes of a binary trace
+#define TRACE_VERSION 1
+#define TRACE_HEADER_SIZE 24         ///< Magic, version, name count, names offset
+#define TRACE_FLAG_COMPACT_ON_FAIL 0x80 ///< Set in an RQ record's strategy byte
+#define TRACE_FLAG_ALIGNED 0x40      ///< Set in an RQ record's strategy byte if a varint alignment follows
+#define BENCH_DEFAULT_MEMORY ((size_t)64 << 20) ///< Heap size when --bench is given none
+#define BENCH_OPS 200000             ///< Timed operations per benchmark run
+#define BENCH_SEED 0x9e3779b97f4a7c15ULL ///< Fixed seed so runs are repeatable
+#define BENCH_THREAD_OPS 100000      ///< Timed operations per thread in --bench-threads
+#define BENCH_THREAD_LIVE 64         ///< Process slots each --bench-threads thread cycles through
+#define BENCH_MAX_THREADS 32         ///< Largest thread count --bench-threads runs
+#define SAMPLE_RING_CAPACITY 65536   ///< Samples SIM --sample keeps; older ones are overwritten
+
+/* ============================================================================
+ * ENUMERATIONS
+ * ============================================================================ */
+
+/**
+ * @enum TraceOpcode
+ * @brief Record types of the binary trace format
+ */
+typedef enum {
+    TRACE_OP_REQUEST = 1,            ///< name id, size, strategy byte
+    TRACE_OP_RELEASE,                ///< name id
+    TRACE_OP_COMPACT,                ///< no operands
+    TRACE_OP_COMPACT_BOUNDED,        ///< max bytes moved
+    TRACE_OP_STAT,                   ///< flags byte (ALLOCATOR_STAT_* bits)
+    TRACE_OP_RESIZE                  ///< name id, new size, strategy byte
+} TraceOpcode;
+
+/**
+ * @enum BenchSizeDistribution
+ * @brief Request size distributions of the benchmark workloads
+ */
+typedef enum {
+    BENCH_SIZES_UNIFORM = 0,         ///< Uniform between 1 byte and 16 KB
+    BENCH_SIZES_POWER_LAW,           ///< Each doubling of the size half as likely, 16 bytes to 1 MB
+    BENCH_SIZES_BIMODAL              ///< 90% small (16-256 bytes), 10% large (64-256 KB)
+} BenchSizeDistribution;
+
+/**
+ * @enum BenchLifetime
+ * @brief Which live process a benchmark workload releases
+ */
+typedef enum {
+    BENCH_LIFETIME_RANDOM = 0,       ///< A uniformly chosen live process
+    BENCH_LIFETIME_LIFO,             ///< The most recently allocated process
+    BENCH_LIFETIME_FIFO              ///< The oldest live process
+} BenchLifetime;
+
+/* ============================================================================
+ * DATA STRUCTURES
+ * ============================================================================ */
+
+/**
+ * @struct BenchResult
+ * @brief Measurements of one benchmark run
+ */
+typedef struct BenchResult {
+    size_t ops;                      ///< Timed allocate/release calls
+    size_t failed;                   ///< Allocations that found no hole
+    double ops_per_sec;              ///< ops divided by the time spent inside the calls
+    uint64_t p50_ns;                 ///< Median latency of a call
+    uint64_t p99_ns;                 ///< 99th percentile latency
+    uint64_t p999_ns;                ///< 99.9th percentile latency
+    size_t peak_blocks;              ///< Most blocks (allocated and free) in the list at once
+} BenchResult;
+
+/**
+ * @struct BenchThread
+ * @brief Work and results of one thread of the contention benchmark
+ */
+typedef struct BenchThread {
+    ArenaAllocator *arenas;          ///< Allocator shared by all threads
+    pthread_barrier_t *start;        ///< Released once every thread is ready
+    unsigned index;                  ///< Thread number, for names and the random seed
+    size_t ops;                      ///< Requests and releases made
+    size_t failed;                   ///< Requests no arena could satisfy
+} BenchThread;
+
+/**
+ * @struct ThreadBenchResult
+ * @brief Measurements of one contention benchmark run
+ */
+typedef struct ThreadBenchResult {
+    size_t ops;                      ///< Calls made by all threads together
+    size_t failed;                   ///< Requests no arena could satisfy
+    size_t steals;                   ///< Requests satisfied outside the caller's home arena
+    size_t cache_hits;               ///< Small requests served from a thread cache
+    size_t cache_misses;             ///< Small requests that refilled a thread cache first
+    double ops_per_sec;              ///< ops divided by the wall-clock time of the run
+} ThreadBenchResult;
+
+/**
+ * @struct FragmentationSample
+ * @brief Fragmentation metrics recorded at one point of a SIM replay
+ */
+typedef struct FragmentationSample {
+    size_t op;                       ///< Commands replayed when the sample was taken
+    double external_fragmentation;   ///< 1 - largest hole / total free, as a percentage
+    size_t largest_hole;             ///< Size of the largest hole
+    size_t hole_count;               ///< Number of holes
+    size_t total_free;               ///< Bytes in holes
+    size_t requests;                 ///< Requests made since the previous sample
+    size_t failed;                   ///< Of those, requests that found no hole
+} FragmentationSample;
+
+/**
+ * @struct SampleRing
+ * @brief Preallocated ring of samples taken every interval commands
+ */
+typedef struct SampleRing {
+    FragmentationSample *samples;    ///< SAMPLE_RING_CAPACITY slots
+    size_t interval;                 ///< Commands between samples
+    size_t countdown;                ///< Commands left until the next sample
+    size_t ops;                      ///< Commands replayed so far
+    size_t recorded;                 ///< Samples taken, including overwritten ones
+    size_t last_requests;            ///< Request count at the previous sample
+    size_t last_failed;              ///< Failed request count at the previous sample
+} SampleRing;
+
+/**
+ * @struct CompareRun
+ * @brief One strategy's replay of a SIM --compare trace
+ */
+typedef struct CompareRun {
+    Allocator *alloc;                ///< Private copy of the REPL allocator
+    AllocatorOp *ops;                ///< Private copy of the trace, requests using this strategy
+    AllocatorResult *results;        ///< One result per operation
+    size_t count;                    ///< Number of operations
+    size_t bytes_moved;              ///< Bytes compaction moved over the whole replay
+    uint64_t elapsed_ns;             ///< Time spent in allocator_apply_batch()
+} CompareRun;
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS
+ * ============================================================================ */
+
+// Command parsing and execution
+static void request_memory(Allocator *alloc, AllocatorName name, size_t size, size_t align,
+                           AllocationStrategy strategy, bool compact_on_fail, bool scan_window);
+static void resize_memory(Allocator *alloc, AllocatorName name, size_t new_size, AllocationStrategy strategy);
+static void print_query(const AllocatorQuery *query, const char *indent);
+static void process_command(Allocator *alloc, const char *command, bool interactive);
+static void run_simulation(Allocator *alloc, const char *command, bool binary);
+static void execute_simulation(Allocator *alloc, const char *filename, SampleRing *ring);
+static AllocationStrategy parse_strategy(char strategy_char);
+static unsigned parse_stat_flags(const char *command);
+static bool parse_map_options(const char *command, size_t *width, size_t *from, size_t *to);
+static bool parse_index_mode(const char *str, HoleIndexMode *mode);
+static bool parse_alignment(const char *command, size_t *align);
+static bool parse_size_classes(const char *str, size_t *classes, size_t *count);
+
+// Binary traces
+static void execute_binary_simulation(Allocator *alloc, const char *filename, SampleRing *ring);
+static TraceOpcode parse_trace_line(const char *line, Allocator *names, AllocatorOp *op,
+                                    FILE *err, const char *file, size_t line_number);
+static int convert_trace(const char *text_file, const char *binary_file);
+
+// Fragmentation sampling
+static bool sample_ring_init(SampleRing *ring, size_t interval);
+static void sample_ring_tick(SampleRing *ring, Allocator *alloc);
+static void sample_ring_dump(const SampleRing *ring, FILE *out);
+static void sample_ring_free(SampleRing *ring);
+
+// Benchmark
+static uint64_t bench_random(uint64_t *state);
+static size_t bench_size(BenchSizeDistribution sizes, uint64_t *state);
+static int run_benchmark(size_t memory_size, HoleIndexMode index_mode, BenchSizeDistribution sizes,
+                         BenchLifetime lifetime, AllocationStrategy strategy, BenchResult *result);
+static int run_benchmarks(const char *csv_file, size_t memory_size, HoleIndexMode index_mode);
+static void *bench_thread_main(void *arg);
+static int run_thread_benchmark(size_t memory_size, HoleIndexMode index_mode, unsigned threads,
+                                unsigned arena_count, bool thread_cache, ThreadBenchResult *result);
+static int run_thread_benchmarks(const char *csv_file, size_t memory_size, HoleIndexMode index_mode);
+
+// Strategy comparison
+static AllocatorOp *load_trace_ops(Allocator *alloc, const char *filename, size_t *count);
+static void *compare_thread_main(void *arg);
+static void compare_strategies(Allocator *alloc, const char *filename);
+
+// Utility functions
+static size_t parse_size(const char *str);
+static int read_line(FILE *file, char *line, size_t size);
+static void trim_whitespace(char *str);
+
+/* ============================================================================
+ * MAIN FUNCTION
+ * ============================================================================ */
+
+/**
+ * @brief Main entry point of the program
+ * 
+ * Initializes the allocator with the specified memory size and enters
+ * the interactive command loop.
+ * 
+ * @param argc Number of command-line arguments
+ * @param argv Array of command-line argument strings
+ * @return EXIT_SUCCESS on success, EXIT_FAILURE on error
+ */
+int main(int argc, char *argv[]) {
+    const char *size_arg = NULL;
+    HoleIndexMode index_mode = HOLE_INDEX_SEGREGATED;
+    bool compact_on_fail = false;
+    size_t size_classes[ALLOCATOR_MAX_SIZE_CLASSES];
+    size_t size_class_count = 0;
+    const char *bench_file = NULL;
+    const char *thread_bench_file = NULL;
+    
+    // Parse options and the memory size argument
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--index=", 8) == 0) {
+            if (!parse_index_mode(argv[i] + 8, &index_mode)) {
+                fprintf(stderr, "Error: Invalid hole index '%s' (use list, seg or tree)\n", argv[i] + 8);
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "--convert") == 0) {
+            // Convert a text trace to a binary trace and exit
+            if (i + 2 >= argc) {
+                fprintf(stderr, "Usage: %s --convert <text_trace> <binary_trace>\n", argv[0]);
+                return EXIT_FAILURE;
+            }
+            return (convert_trace(argv[i + 1], argv[i + 2]) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+        } else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            bench_file = argv[++i];
+        } else if (strcmp(argv[i], "--bench-threads") == 0 && i + 1 < argc) {
+            thread_bench_file = argv[++i];
+        } else if (strcmp(argv[i], "--compact-on-fail") == 0) {
+            compact_on_fail = true;
+        } else if (strncmp(argv[i], "--size-classes=", 15) == 0) {
+            if (!parse_size_classes(argv[i] + 15, size_classes, &size_class_count)) {
+                fprintf(stderr, "Error: Invalid size classes '%s' (use increasing sizes such as 16,32,64,4K)\n",
+                        argv[i] + 15);
+                return EXIT_FAILURE;
+            }
+        } else if (size_arg == NULL) {
+            size_arg = argv[i];
+        } else {
+            size_arg = NULL;
+            bench_file = NULL;
+            thread_bench_file = NULL;
+            break;
+        }
+    }
+    
+    // Check for correct number of arguments (the benchmarks have a default size)
+    if (size_arg == NULL && bench_file == NULL && thread_bench_file == NULL) {
+        fprintf(stderr, "Usage: %s <memory_size> [--index=list|seg|tree] [--compact-on-fail] [--size-classes=<list>]\n",
+                argv[0]);
+        fprintf(stderr, "       %s --convert <text_trace> <binary_trace>\n", argv[0]);
+        fprintf(stderr, "       %s [memory_size] [--index=list|seg|tree] --bench <csv_file>\n", argv[0]);
+        fprintf(stderr, "       %s [memory_size] [--index=list|seg|tree] --bench-threads <csv_file>\n", argv[0]);
+        fprintf(stderr, "Example: %s 1048576\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    
+    // Parse memory size
+    size_t memory_size = (size_arg != NULL) ? parse_size(size_arg) : BENCH_DEFAULT_MEMORY;
+    if (memory_size == 0) {
+        fprintf(stderr, "Error: Invalid memory size '%s'\n", size_arg);
+        return EXIT_FAILURE;
+    }
+    
+    if (bench_file != NULL) {
+        return (run_benchmarks(bench_file, memory_size, index_mode) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (thread_bench_file != NULL) {
+        return (run_thread_benchmarks(thread_bench_file, memory_size, index_mode) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    
+    // Initialize allocator
+    Allocator *alloc = allocator_create(memory_size, index_mode);
+    if (alloc == NULL) {
+        fprintf(stderr, "Error: Failed to initialize allocator\n");
+        return EXIT_FAILURE;
+    }
+    allocator_set_compact_on_fail(alloc, compact_on_fail);
+    allocator_set_size_classes(alloc, size_classes, size_class_count);
+    
+    // Interactive command loop
+    char line[MAX_LINE_LENGTH];
+    printf("allocator>");
+    fflush(stdout);
+    
+    int status;
+    while ((status = read_line(stdin, line, sizeof(line))) != 0) {
+        if (status < 0) {
+            printf("Error: Command longer than %d characters\n", MAX_LINE_LENGTH - 1);
+        }
+        
+        // Skip empty lines
+        if (strlen(line) == 0) {
+            printf("allocator>");
+            fflush(stdout);
+            continue;
+        }
+        
+        // Process command
+        process_command(alloc, line, true);
+        
+        // Check if we should exit
+        if (strcmp(line, "X") == 0) {
+            break;
+        }
+        
+        printf("allocator>");
+        fflush(stdout);
+    }
+    
+    // Cleanup
+    allocator_destroy(alloc);
+    
+    return EXIT_SUCCESS;
+}
+
+/* ============================================================================
+ * COMMAND PARSING AND EXECUTION
+ * ============================================================================ */
+
+/**
+ * @brief Parse allocation strategy character
+ * 
+ * @param strategy_char Character representing strategy (F, B, W, Y, T or N)
+ * @return AllocationStrategy enum value
+ */
+static AllocationStrategy parse_strategy(char strategy_char) {
+    switch (toupper(strategy_char)) {
+        case 'F':
+            return STRATEGY_FIRST_FIT;
+        case 'B':
+            return STRATEGY_BEST_FIT;
+        case 'W':
+            return STRATEGY_WORST_FIT;
+        case 'Y':
+            return STRATEGY_BUDDY;
+        case 'T':
+            return STRATEGY_TLSF;
+        case 'N':
+            return STRATEGY_NEXT_FIT;
+        default:
+            return STRATEGY_FIRST_FIT; // Default to first fit
+    }
+}
+
+/**
+ * @brief Parse the options of a STAT command
+ * 
+ * @param command STAT command line
+ * @return ALLOCATOR_STAT_* flags for -s, -v and -t
+ */
+static unsigned parse_stat_flags(const char *command) {
+    unsigned flags = 0;
+    if (strstr(command, "-s") != NULL) {
+        flags |= ALLOCATOR_STAT_SUMMARY;
+    }
+    if (strstr(command, "-v") != NULL) {
+        flags |= ALLOCATOR_STAT_VISUALIZE;
+    }
+    if (strstr(command, "-t") != NULL) {
+        flags |= ALLOCATOR_STAT_TLSF;
+    }
+    return flags;
+}
+
+/**
+ * @brief Parse the memory map options of a STAT -v command
+ * 
+ * Besides the flags, STAT -v takes an optional column count and an
+ * optional address range "from-to" (sizes may carry KB/MB suffixes).
+ * 
+ * @param command STAT command line
+ * @param width Output: column count (left unchanged if none is given)
+ * @param from Output: start of the range (left unchanged if none is given)
+ * @param to Output: end of the range (left unchanged if none is given)
+ * @return true if the options are valid, false otherwise
+ */
+static bool parse_map_options(const char *command, size_t *width, size_t *from, size_t *to) {
+    char copy[MAX_LINE_LENGTH];
+    strncpy(copy, command, sizeof(copy) - 1);
+    copy[sizeof(copy) - 1] = '\0';
+    
+    bool options = false;
+    char *token = strtok(copy + 4, " \t");
+    for (; token != NULL; token = strtok(NULL, " \t")) {
+        char *dash = strchr(token, '-');
+        if (dash == token) {
+            continue; // A flag
+        }
+        options = true;
+        if (dash == NULL) {
+            char *endptr;
+            unsigned long value = strtoul(token, &endptr, 10);
+            if (!isdigit((unsigned char)token[0]) || *endptr != '\0' || value == 0) {
+                return false;
+            }
+            *width = (size_t)value;
+        } else {
+            *dash = '\0';
+            size_t start = parse_size(token);
+            size_t end = parse_size(dash + 1);
+            if ((start == 0 && strspn(token, "0") != strlen(token)) || end <= start) {
+                return false;
+            }
+            *from = start;
+            *to = end;
+        }
+    }
+    return !options || (parse_stat_flags(command) & ALLOCATOR_STAT_VISUALIZE) != 0;
+}
+
+/**
+ * @brief Parse a --index= startup option value
+ * 
+ * @param str Option value (list, seg or tree)
+ * @param mode Output: parsed hole index mode
+ * @return true if the value was recognised, false otherwise
+ */
+static bool parse_index_mode(const char *str, HoleIndexMode *mode) {
+    if (strcmp(str, "list") == 0) {
+        *mode = HOLE_INDEX_LIST;
+    } else if (strcmp(str, "seg") == 0) {
+        *mode = HOLE_INDEX_SEGREGATED;
+    } else if (strcmp(str, "tree") == 0) {
+        *mode = HOLE_INDEX_TREE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Parse the optional align=N option of an RQ command
+ * 
+ * @param command RQ command line
+ * @param align Output: alignment, 1 if the option is absent
+ * @return true unless the option is given with a value that is not a power of two
+ */
+static bool parse_alignment(const char *command, size_t *align) {
+    *align = 1;
+    const char *option = strstr(command, " align=");
+    if (option == NULL) {
+        return true;
+    }
+    
+    char value[64];
+    if (sscanf(option + 7, "%63s", value) != 1) {
+        return false;
+    }
+    *align = parse_size(value);
+    return *align != 0 && (*align & (*align - 1)) == 0;
+}
+
+/**
+ * @brief Parse a --size-classes= startup option value
+ * 
+ * @param str Comma-separated sizes in increasing order (KB/MB suffixes allowed)
+ * @param classes Output: the sizes (ALLOCATOR_MAX_SIZE_CLASSES entries)
+ * @param count Output: number of sizes
+ * @return true if the list is valid, false otherwise
+ */
+static bool parse_size_classes(const char *str, size_t *classes, size_t *count) {
+    char copy[MAX_LINE_LENGTH];
+    if (strlen(str) >= sizeof(copy)) {
+        return false;
+    }
+    strcpy(copy, str);
+    
+    *count = 0;
+    for (char *token = strtok(copy, ","); token != NULL; token = strtok(NULL, ",")) {
+        if (*count == ALLOCATOR_MAX_SIZE_CLASSES) {
+            return false;
+        }
+        size_t size = parse_size(token);
+        if (size == 0 || (*count > 0 && size <= classes[*count - 1])) {
+            return false;
+        }
+        classes[(*count)++] = size;
+    }
+    return *count > 0;
+}
+
+/**
+ * @brief Carry out a validated RQ and report the outcome
+ * 
+ * Shared by the text and binary trace paths so both print the same output.
+ * 
+ * @param alloc Allocator to allocate from
+ * @param name Interned name of the requesting process
+ * @param size Size to allocate (non-zero)
+ * @param align Alignment of the block's start (a power of two)
+ * @param strategy Allocation strategy to use
+ * @param compact_on_fail Whether to compact a window and retry if no hole fits
+ * @param scan_window Whether a failure looks for the window compaction would slide (O(n))
+ */
+static void request_memory(Allocator *alloc, AllocatorName name, size_t size, size_t align,
+                           AllocationStrategy strategy, bool compact_on_fail, bool scan_window) {
+    AllocatorResult result;
+    allocator_request_aligned(alloc, name, size, align, strategy, compact_on_fail, &result);
+    
+    if (result.compacted) {
+        printf("Compaction moved %zu bytes to make room for process '%s'\n",
+               result.bytes_moved, allocator_name_string(alloc, name));
+    }
+    if (result.status == ALLOCATOR_DUPLICATE) {
+        printf("Error: Process '%s' already exists\n", allocator_name_string(alloc, name));
+    } else if (result.status != ALLOCATOR_OK) {
+        printf("Error: Insufficient memory to allocate %zu bytes for process '%s'\n",
+               size, allocator_name_string(alloc, name));
+        
+        // Say why, from the same indexes the search used
+        AllocatorQuery query;
+        if (result.status == ALLOCATOR_NO_SPACE &&
+            allocator_query(alloc, size, align, strategy, &query) == ALLOCATOR_OK) {
+            if (scan_window) {
+                allocator_query_window(alloc, &query);
+            }
+            print_query(&query, "  ");
+        }
+    }
+}
+
+/**
+ * @brief Print why a request does or does not fit, as found by allocator_query()
+ * 
+ * @param query Findings to print
+ * @param indent Prefix for every line
+ */
+static void print_query(const AllocatorQuery *query, const char *indent) {
+    printf("%sLargest hole: %zu bytes, largest request that fits: %zu bytes\n",
+           indent, query->largest_hole, query->largest_request);
+    printf("%sFree memory: %zu bytes in %zu hole%s\n",
+           indent, query->total_free, query->hole_count, query->hole_count == 1 ? "" : "s");
+    if (query->fits) {
+        return;
+    }
+    if (query->compaction_fits && query->window_checked) {
+        printf("%sCompaction would make room by moving at most %zu bytes\n", indent, query->bytes_to_move);
+    } else if (query->compaction_fits) {
+        printf("%sCompaction would make room\n", indent);
+    } else if (query->needed == SIZE_MAX) {
+        printf("%sCompaction cannot make room: no hole can be large enough\n", indent);
+    } else if (query->needed <= query->total_free && query->window_checked) {
+        printf("%sCompaction cannot make room: alignment padding would leave no %zu-byte hole\n",
+               indent, query->needed);
+    } else if (query->needed <= query->total_free) {
+        printf("%sCompaction may not make room: alignment padding may keep up to %zu of the %zu free bytes\n",
+               indent, query->align_reserve, query->total_free);
+    } else {
+        printf("%sCompaction cannot make room: it needs a %zu-byte hole but only %zu bytes are free\n",
+               indent, query->needed, query->total_free);
+    }
+}
+
+/**
+ * @brief Resize a process's memory and report a failure
+ * 
+ * @param alloc Allocator the process's memory belongs to
+ * @param name Interned process name
+ * @param new_size New size in bytes
+ * @param strategy Allocation strategy used if the block has to move
+ */
+static void resize_memory(Allocator *alloc, AllocatorName name, size_t new_size, AllocationStrategy strategy) {
+    AllocatorStatus status = allocator_resize(alloc, name, new_size, strategy, NULL);
+    if (status == ALLOCATOR_NOT_FOUND || status == ALLOCATOR_INVALID) {
+        printf("Error: Process '%s' not found\n", allocator_name_string(alloc, name));
+    } else if (status != ALLOCATOR_OK) {
+        printf("Error: Insufficient memory to resize process '%s' to %zu bytes\n",
+               allocator_name_string(alloc, name), new_size);
+    }
+}
+
+/**
+ * @brief Process a single command
+ * 
+ * @param alloc Allocator the command applies to
+ * @param command Command string to process
+ * @param interactive Whether it was typed at the prompt rather than read from a trace
+ */
+static void process_command(Allocator *alloc, const char *command, bool interactive) {
+    char cmd_copy[MAX_LINE_LENGTH];
+    strncpy(cmd_copy, command, sizeof(cmd_copy) - 1);
+    cmd_copy[sizeof(cmd_copy) - 1] = '\0';
+    
+    trim_whitespace(cmd_copy);
+    
+    // Handle empty commands
+    if (strlen(cmd_copy) == 0) {
+        return;
+    }
+    
+    // Parse command
+    if (strncmp(cmd_copy, "RQ ", 3) == 0) {
+        // Request memory: RQ <process> <size> <F|B|W|Y|T|N> [align=N] [--compact-on-fail]
+        char process_name[MAX_PROCESS_NAME_LENGTH];
+        char size_str[64];
+        char strategy_char;
+        
+        if (sscanf(cmd_copy + 3, "%63s %63s %c", process_name, size_str, &strategy_char) != 3) {
+            printf("Error: Invalid RQ command format. Use: RQ <process> <size> <F|B|W|Y|T|N> [align=N] [--compact-on-fail]\n");
+            return;
+        }
+        
+        // Validate process name
+        if (!allocator_valid_name(process_name)) {
+            printf("Error: Invalid process name '%s'\n", process_name);
+            return;
+        }
+        
+        // Check for duplicate process name
+        if (allocator_holds_memory(alloc, allocator_find_name(alloc, process_name))) {
+            printf("Error: Process '%s' already exists\n", process_name);
+            return;
+        }
+        
+        size_t size = parse_size(size_str);
+        if (size == 0) {
+            printf("Error: Invalid size '%s'\n", size_str);
+            return;
+        }
+        
+        size_t align;
+        if (!parse_alignment(cmd_copy, &align)) {
+            printf("Error: Invalid alignment (must be a power of two)\n");
+            return;
+        }
+        
+        AllocatorName name = allocator_name(alloc, process_name);
+        if (name == ALLOCATOR_NO_NAME) {
+            printf("Error: Insufficient memory to allocate %zu bytes for process '%s'\n", size, process_name);
+            return;
+        }
+        
+        request_memory(alloc, name, size, align, parse_strategy(strategy_char),
+                       strstr(cmd_copy, "--compact-on-fail") != NULL, interactive);
+        
+    } else if (strncmp(cmd_copy, "RL ", 3) == 0) {
+        // Release memory: RL <process>
+        char process_name[MAX_PROCESS_NAME_LENGTH];
+        
+        if (sscanf(cmd_copy + 3, "%63s", process_name) != 1) {
+            printf("Error: Invalid RL command format. Use: RL <process>\n");
+            return;
+        }
+        
+        if (allocator_release(alloc, allocator_find_name(alloc, process_name)) != ALLOCATOR_OK) {
+            printf("Error: Process '%s' not found\n", process_name);
+        }
+        
+    } else if (strncmp(cmd_copy, "RS ", 3) == 0) {
+        // Resize memory: RS <process> <new_size> [F|B|W|Y|T|N]
+        char process_name[MAX_PROCESS_NAME_LENGTH];
+        char size_str[64];
+        char strategy_char = 'F';
+        
+        if (sscanf(cmd_copy + 3, "%63s %63s %c", process_name, size_str, &strategy_char) < 2) {
+            printf("Error: Invalid RS command format. Use: RS <process> <new_size> [F|B|W|Y|T|N]\n");
+            return;
+        }
+        
+        AllocatorName name = allocator_find_name(alloc, process_name);
+        if (!allocator_holds_memory(alloc, name)) {
+            printf("Error: Process '%s' not found\n", process_name);
+            return;
+        }
+        
+        size_t size = parse_size(size_str);
+        if (size == 0) {
+            printf("Error: Invalid size '%s'\n", size_str);
+            return;
+        }
+        
+        resize_memory(alloc, name, size, parse_strategy(strategy_char));
+        
+    } else if (strncmp(cmd_copy, "QUERY ", 6) == 0) {
+        // Query a request without making it: QUERY <size> [F|B|W|Y|T|N] [align=N]
+        char size_str[64];
+        char strategy_char = 'F';
+        
+        if (sscanf(cmd_copy + 6, "%63s %c", size_str, &strategy_char) < 1) {
+            printf("Error: Invalid QUERY command format. Use: QUERY <size> [F|B|W|Y|T|N] [align=N]\n");
+            return;
+        }
+        
+        size_t size = parse_size(size_str);
+        if (size == 0) {
+            printf("Error: Invalid size '%s'\n", size_str);
+            return;
+        }
+        
+        size_t align;
+        if (!parse_alignment(cmd_copy, &align)) {
+            printf("Error: Invalid alignment (must be a power of two)\n");
+            return;
+        }
+        
+        AllocatorQuery query;
+        allocator_query(alloc, size, align, parse_strategy(strategy_char), &query);
+        allocator_query_window(alloc, &query);
+        if (query.size != size) {
+            printf("Request of %zu bytes (%zu with its size class): %s\n",
+                   size, query.size, query.fits ? "fits" : "does not fit");
+        } else {
+            printf("Request of %zu bytes: %s\n", size, query.fits ? "fits" : "does not fit");
+        }
+        print_query(&query, "");
+        
+    } else if (strcmp(cmd_copy, "C") == 0) {
+        // Compact memory
+        allocator_compact(alloc, SIZE_MAX);
+        
+    } else if (strncmp(cmd_copy, "C ", 2) == 0) {
+        // Bounded compaction: C <max_bytes_moved>
+        char budget_str[64];
+        
+        if (sscanf(cmd_copy + 2, "%63s", budget_str) != 1) {
+            printf("Error: Invalid C command format. Use: C [max_bytes_moved]\n");
+            return;
+        }
+        
+        size_t budget = parse_size(budget_str);
+        if (budget == 0) {
+            printf("Error: Invalid byte budget '%s'\n", budget_str);
+            return;
+        }
+        
+        printf("Compaction moved %zu bytes\n", allocator_compact(alloc, budget));
+        
+    } else if (strncmp(cmd_copy, "STAT", 4) == 0) {
+        // Status report: STAT [-s] [-t] [-v [width] [from-to]]
+        unsigned flags = parse_stat_flags(cmd_copy);
+        size_t width = ALLOCATOR_MAP_WIDTH;
+        size_t from = 0;
+        size_t to = SIZE_MAX;
+        
+        if (!parse_map_options(cmd_copy, &width, &from, &to)) {
+            printf("Error: Invalid STAT command format. Use: STAT [-s] [-t] [-v [width] [from-to]]\n");
+            return;
+        }
+        
+        // A zoomed map also narrows the listing to its range
+        if (to != SIZE_MAX && (flags & ALLOCATOR_STAT_SUMMARY) == 0) {
+            allocator_print_blocks(alloc, stdout, from, to);
+            flags |= ALLOCATOR_STAT_SUMMARY;
+        }
+        allocator_print_statistics(alloc, stdout, flags & ~ALLOCATOR_STAT_VISUALIZE);
+        if (flags & ALLOCATOR_STAT_VISUALIZE) {
+            printf("\n");
+            allocator_print_map(alloc, stdout, width, from, to);
+        }
+        
+    } else if (strncmp(cmd_copy, "SAVE ", 5) == 0 || strncmp(cmd_copy, "LOAD ", 5) == 0) {
+        // Snapshots: SAVE <filename>, LOAD <filename>
+        char filename[MAX_LINE_LENGTH];
+        bool save = (cmd_copy[0] == 'S');
+        
+        if (sscanf(cmd_copy + 5, "%s", filename) != 1) {
+            printf("Error: Invalid %.4s command format. Use: %.4s <filename>\n", cmd_copy, cmd_copy);
+            return;
+        }
+        
+        if (save && !allocator_save(alloc, filename)) {
+            printf("Error: Cannot write snapshot '%s'\n", filename);
+        } else if (!save && !allocator_load(alloc, filename)) {
+            printf("Error: Cannot load snapshot '%s'\n", filename);
+        } else {
+            AllocatorStats stats;
+            allocator_get_stats(alloc, &stats);
+            printf("%s %zu blocks (%zu processes, %zu bytes of memory) %s '%s'\n", save ? "Saved" : "Loaded",
+                   stats.block_count, stats.process_count, stats.total_size, save ? "to" : "from", filename);
+        }
+        
+    } else if (strncmp(cmd_copy, "SIM --compare ", 14) == 0) {
+        // Strategy comparison: SIM --compare <filename>
+        char filename[MAX_LINE_LENGTH];
+        
+        if (sscanf(cmd_copy + 14, "%s", filename) != 1) {
+            printf("Error: Invalid SIM command format. Use: SIM --compare <filename>\n");
+            return;
+        }
+        
+        compare_strategies(alloc, filename);
+        
+    } else if (strncmp(cmd_copy, "SIM -b ", 7) == 0) {
+        // Binary trace replay: SIM -b <filename> [--sample=N]
+        run_simulation(alloc, cmd_copy + 7, true);
+        
+    } else if (strncmp(cmd_copy, "SIM ", 4) == 0) {
+        // Simulation mode: SIM <filename> [--sample=N]
+        run_simulation(alloc, cmd_copy + 4, false);
+        
+    } else if (strcmp(cmd_copy, "X") == 0) {
+        // Exit - handled in main loop
+        return;
+        
+    } else {
+        printf("Error: Unknown command '%s'\n", cmd_copy);
+        printf("Valid commands: RQ, RL, RS, QUERY, C, STAT, STAT -v, SIM, SAVE, LOAD, X\n");
+    }
+}
+
+/**
+ * @brief Parse the operands of a SIM command and replay the trace
+ * 
+ * With --sample=N the fragmentation metrics are recorded every N
+ * commands and printed as CSV once the trace has been replayed.
+ * 
+ * @param alloc Allocator the trace applies to
+ * @param command Operands following "SIM " or "SIM -b "
+ * @param binary Whether the trace is a binary one
+ */
+static void run_simulation(Allocator *alloc, const char *command, bool binary) {
+    const char *usage = binary ? "SIM -b <filename> [--sample=N]" : "SIM <filename> [--sample=N]";
+    char filename[MAX_LINE_LENGTH];
+    char option[MAX_LINE_LENGTH];
+    
+    int fields = sscanf(command, "%s %s", filename, option);
+    if (fields < 1) {
+        printf("Error: Invalid SIM command format. Use: %s\n", usage);
+        return;
+    }
+    
+    size_t interval = 0;
+    if (fields == 2) {
+        char *endptr;
+        unsigned long long value = (strncmp(option, "--sample=", 9) == 0 && isdigit((unsigned char)option[9]))
+                                   ? strtoull(option + 9, &endptr, 10) : 0;
+        if (value == 0 || *endptr != '\0' || value > SIZE_MAX) {
+            printf("Error: Invalid SIM command format. Use: %s\n", usage);
+            return;
+        }
+        interval = (size_t)value;
+    }
+    
+    SampleRing ring;
+    if (interval > 0 && !sample_ring_init(&ring, interval)) {
+        printf("Error: Failed to allocate sample buffer\n");
+        return;
+    }
+    
+    if (binary) {
+        execute_binary_simulation(alloc, filename, interval > 0 ? &ring : NULL);
+    } else {
+        execute_simulation(alloc, filename, interval > 0 ? &ring : NULL);
+    }
+    
+    if (interval > 0) {
+        sample_ring_dump(&ring, stdout);
+        sample_ring_free(&ring);
+    }
+}
+
+/**
+ * @brief Execute commands from a file
+ * 
+ * @param alloc Allocator the commands apply to
+ * @param filename Name of the file containing commands
+ * @param ring Samples to record after each command, or NULL
+ */
+static void execute_simulation(Allocator *alloc, const char *filename, SampleRing *ring) {
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) {
+        printf("Error: Cannot open file '%s'\n", filename);
+        return;
+    }
+    
+    char line[MAX_LINE_LENGTH];
+    size_t line_number = 0;
+    int status;
+    
+    while ((status = read_line(file, line, sizeof(line))) != 0) {
+        line_number++;
+        if (status < 0) {
+            printf("Error: %s:%zu: Line longer than %d characters\n", filename, line_number, MAX_LINE_LENGTH - 1);
+            continue;
+        }
+        
+        // Skip empty lines and comments
+        trim_whitespace(line);
+        if (strlen(line) == 0 || line[0] == '#') {
+            continue;
+        }
+        
+        // Process command
+        process_command(alloc, line, false);
+        sample_ring_tick(ring, alloc);
+    }
+    
+    fclose(file);
+}
+
+/* ============================================================================
+ * BINARY TRACES
+ * ============================================================================ */
+
+/**
+ * @brief Append an unsigned LEB128 varint to a file
+ * 
+ * @param file Output file
+ * @param value Value to encode
+ */
+static void write_varint(FILE *file, size_t value) {
+    while (value >= 0x80) {
+        putc((int)((value & 0x7f) | 0x80), file);
+        value >>= 7;
+    }
+    putc((int)value, file);
+}
+
+/**
+ * @brief Write a little-endian integer of the given width
+ * 
+ * @param file Output file
+ * @param value Value to encode
+ * @param bytes Width in bytes
+ */
+static void write_le(FILE *file, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        putc((int)((value >> (8 * i)) & 0xff), file);
+    }
+}
+
+/**
+ * @brief Read a little-endian integer of the given width
+ * 
+ * @param data Bytes to decode
+ * @param bytes Width in bytes
+ * @return Decoded value
+ */
+static uint64_t read_le(const uint8_t *data, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value |= (uint64_t)data[i] << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * @brief Decode an unsigned LEB128 varint, checking the buffer bounds
+ * 
+ * @param data Trace bytes
+ * @param end Offset the varint must not run past
+ * @param pos In/out: offset of the varint, advanced past it
+ * @param value Output: decoded value
+ * @return true on success, false if the varint is truncated or too long
+ */
+static bool read_varint(const uint8_t *data, size_t end, size_t *pos, size_t *value) {
+    size_t result = 0;
+    for (unsigned shift = 0; shift < sizeof(size_t) * CHAR_BIT; shift += 7) {
+        if (*pos >= end) {
+            return false;
+        }
+        uint8_t byte = data[(*pos)++];
+        result |= (size_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Parse one command of a text trace into a batch operation
+ * 
+ * Names are interned into the given allocator, so one name always gets
+ * the same id. RQ, RL, RS and both forms of C give the matching operation;
+ * STAT gives no operation but its flags in op->size.
+ * 
+ * @param line Trimmed, non-empty, non-comment line
+ * @param names Allocator to intern process names into
+ * @param op Output: the operation
+ * @param err Stream to report an invalid line on
+ * @param file Trace path, for error messages
+ * @param line_number Line number, for error messages
+ * @return The line's binary trace opcode, or 0 if the line is invalid
+ */
+static TraceOpcode parse_trace_line(const char *line, Allocator *names, AllocatorOp *op,
+                                    FILE *err, const char *file, size_t line_number) {
+    memset(op, 0, sizeof(AllocatorOp));
+    
+    if (strncmp(line, "RQ ", 3) == 0) {
+        char process_name[MAX_PROCESS_NAME_LENGTH];
+        char size_str[64];
+        char strategy_char;
+        if (sscanf(line + 3, "%63s %63s %c", process_name, size_str, &strategy_char) != 3 ||
+            !allocator_valid_name(process_name) || parse_size(size_str) == 0 ||
+            !parse_alignment(line, &op->align)) {
+            fprintf(err, "Error: %s:%zu: Invalid RQ command\n", file, line_number);
+            return 0;
+        }
+        op->name = allocator_name(names, process_name);
+        if (op->name == ALLOCATOR_NO_NAME) {
+            fprintf(err, "Error: Failed to allocate name table\n");
+            return 0;
+        }
+        op->type = ALLOCATOR_OP_REQUEST;
+        op->size = parse_size(size_str);
+        op->strategy = parse_strategy(strategy_char);
+        op->compact_on_fail = strstr(line, "--compact-on-fail") != NULL;
+        return TRACE_OP_REQUEST;
+    }
+    if (strncmp(line, "RL ", 3) == 0) {
+        char process_name[MAX_PROCESS_NAME_LENGTH];
+        if (sscanf(line + 3, "%63s", process_name) != 1 ||
+            (op->name = allocator_name(names, process_name)) == ALLOCATOR_NO_NAME) {
+            fprintf(err, "Error: %s:%zu: Invalid RL command\n", file, line_number);
+            return 0;
+        }
+        op->type = ALLOCATOR_OP_RELEASE;
+        return TRACE_OP_RELEASE;
+    }
+    if (strncmp(line, "RS ", 3) == 0) {
+        char process_name[MAX_PROCESS_NAME_LENGTH];
+        char size_str[64];
+        char strategy_char = 'F';
+        if (sscanf(line + 3, "%63s %63s %c", process_name, size_str, &strategy_char) < 2 ||
+            !allocator_valid_name(process_name) || parse_size(size_str) == 0) {
+            fprintf(err, "Error: %s:%zu: Invalid RS command\n", file, line_number);
+            return 0;
+        }
+        op->name = allocator_name(names, process_name);
+        if (op->name == ALLOCATOR_NO_NAME) {
+            fprintf(err, "Error: Failed to allocate name table\n");
+            return 0;
+        }
+        op->type = ALLOCATOR_OP_RESIZE;
+        op->size = parse_size(size_str);
+        op->strategy = parse_strategy(strategy_char);
+        return TRACE_OP_RESIZE;
+    }
+    if (strcmp(line, "C") == 0) {
+        op->type = ALLOCATOR_OP_COMPACT;
+        op->size = SIZE_MAX;
+        return TRACE_OP_COMPACT;
+    }
+    if (strncmp(line, "C ", 2) == 0) {
+        char budget_str[64];
+        if (sscanf(line + 2, "%63s", budget_str) != 1 || (op->size = parse_size(budget_str)) == 0) {
+            fprintf(err, "Error: %s:%zu: Invalid C command\n", file, line_number);
+            return 0;
+        }
+        op->type = ALLOCATOR_OP_COMPACT;
+        return TRACE_OP_COMPACT_BOUNDED;
+    }
+    size_t width = ALLOCATOR_MAP_WIDTH;
+    size_t from = 0;
+    size_t to = SIZE_MAX;
+    if (strncmp(line, "STAT", 4) == 0 && parse_map_options(line, &width, &from, &to) &&
+        width == ALLOCATOR_MAP_WIDTH && from == 0 && to == SIZE_MAX) {
+        // The binary format has no room for map options
+        op->size = parse_stat_flags(line);
+        return TRACE_OP_STAT;
+    }
+    fprintf(err, "Error: %s:%zu: Command not supported in trace files: %s\n", file, line_number, line);
+    return 0;
+}
+
+/**
+ * @brief Convert a text trace into the binary trace format
+ * 
+ * Layout (integers little-endian):
+ * - Header: "CMATRACE", u32 version, u32 name count, u64 offset of the names
+ * - Records: one opcode byte followed by its operands, sizes as varints
+ * - Names: NUL-terminated strings, the i-th one having trace name id i
+ * 
+ * Names are interned while the records are written and appended at the end,
+ * so the text trace is read only once.
+ * 
+ * @param text_file Path of the text trace
+ * @param binary_file Path of the binary trace to write
+ * @return 0 on success, -1 on error
+ */
+static int convert_trace(const char *text_file, const char *binary_file) {
+    FILE *in = fopen(text_file, "r");
+    if (in == NULL) {
+        fprintf(stderr, "Error: Cannot open file '%s'\n", text_file);
+        return -1;
+    }
+    FILE *out = fopen(binary_file, "wb");
+    if (out == NULL) {
+        fprintf(stderr, "Error: Cannot create file '%s'\n", binary_file);
+        fclose(in);
+        return -1;
+    }
+    
+    // A scratch allocator interns the names: it hands out dense ids from 1
+    Allocator *names = allocator_create(1, HOLE_INDEX_LIST);
+    AllocatorName name_count = 0;
+    if (names == NULL) {
+        fprintf(stderr, "Error: Failed to allocate name table\n");
+        fclose(in);
+        fclose(out);
+        return -1;
+    }
+    
+    // Header, with the names offset patched in at the end
+    fwrite(TRACE_MAGIC, 1, 8, out);
+    write_le(out, TRACE_VERSION, 4);
+    write_le(out, 0, 4);
+    write_le(out, 0, 8);
+    
+    char line[MAX_LINE_LENGTH];
+    size_t line_number = 0;
+    size_t records = 0;
+    int status = 0;
+    int read;
+    
+    while (status == 0 && (read = read_line(in, line, sizeof(line))) != 0) {
+        line_number++;
+        if (read < 0) {
+            fprintf(stderr, "Error: %s:%zu: Line longer than %d characters\n", text_file, line_number,
+                    MAX_LINE_LENGTH - 1);
+            status = -1;
+            break;
+        }
+        trim_whitespace(line);
+        if (strlen(line) == 0 || line[0] == '#') {
+            continue;
+        }
+        
+        AllocatorOp op;
+        TraceOpcode opcode = parse_trace_line(line, names, &op, stderr, text_file, line_number);
+        if (opcode == 0) {
+            status = -1;
+            break;
+        }
+        
+        putc(opcode, out);
+        switch (opcode) {
+            case TRACE_OP_REQUEST:
+                write_varint(out, op.name);
+                write_varint(out, op.size);
+                putc((int)op.strategy | (op.compact_on_fail ? TRACE_FLAG_COMPACT_ON_FAIL : 0) |
+                     (op.align > 1 ? TRACE_FLAG_ALIGNED : 0), out);
+                if (op.align > 1) {
+                    write_varint(out, op.align);
+                }
+                break;
+            case TRACE_OP_RESIZE:
+                write_varint(out, op.name);
+                write_varint(out, op.size);
+                putc((int)op.strategy, out);
+                break;
+            case TRACE_OP_RELEASE:
+                write_varint(out, op.name);
+                break;
+            case TRACE_OP_COMPACT_BOUNDED:
+                write_varint(out, op.size);
+                break;
+            case TRACE_OP_STAT:
+                putc((int)op.size, out);
+                break;
+            default:
+                break;
+        }
+        if (op.name > name_count) {
+            name_count = op.name;
+        }
+        records++;
+    }
+    
+    if (status == 0) {
+        // Names section, then patch the header
+        long names_offset = ftell(out);
+        for (AllocatorName id = 1; id <= name_count; id++) {
+            const char *name = allocator_name_string(names, id);
+            fwrite(name, 1, strlen(name) + 1, out);
+        }
+        fseek(out, 12, SEEK_SET);
+        write_le(out, name_count, 4);
+        write_le(out, (uint64_t)names_offset, 8);
+        if (ferror(out)) {
+            fprintf(stderr, "Error: Failed to write '%s'\n", binary_file);
+            status = -1;
+        } else {
+            printf("Converted %zu commands (%u process names) to '%s'\n",
+                   records, (unsigned)name_count, binary_file);
+        }
+    }
+    
+    allocator_destroy(names);
+    fclose(in);
+    if (fclose(out) != 0) {
+        status = -1;
+    }
+    if (status != 0) {
+        remove(binary_file);
+    }
+    return status;
+}
+
+/**
+ * @brief Replay a binary trace straight from a read-only mapping
+ * 
+ * The trace's names are interned once up front, so each record is decoded
+ * in place and dispatched without copying, tokenizing or hashing anything.
+ * Output matches replaying the text trace it was converted from.
+ * 
+ * @param alloc Allocator the trace applies to
+ * @param filename Path of the binary trace
+ * @param ring Samples to record after each record, or NULL
+ */
+static void execute_binary_simulation(Allocator *alloc, const char *filename, SampleRing *ring) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        printf("Error: Cannot open file '%s'\n", filename);
+        return;
+    }
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < TRACE_HEADER_SIZE) {
+        printf("Error: '%s' is not a binary trace\n", filename);
+        close(fd);
+        return;
+    }
+    size_t length = (size_t)info.st_size;
+    
+    const uint8_t *data = (const uint8_t *)mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        printf("Error: Cannot map file '%s'\n", filename);
+        return;
+    }
+    posix_madvise((void *)data, length, POSIX_MADV_SEQUENTIAL);
+    
+    uint32_t name_count = (uint32_t)read_le(data + 12, 4);
+    uint64_t names_offset = read_le(data + 16, 8);
+    if (memcmp(data, TRACE_MAGIC, 8) != 0 || read_le(data + 8, 4) != TRACE_VERSION ||
+        names_offset < TRACE_HEADER_SIZE || names_offset > length) {
+        printf("Error: '%s' is not a binary trace\n", filename);
+        munmap((void *)data, length);
+        return;
+    }
+    
+    // Map trace name ids to allocator name ids
+    AllocatorName *ids = (AllocatorName *)malloc(((size_t)name_count + 1) * sizeof(AllocatorName));
+    if (ids == NULL) {
+        printf("Error: Failed to allocate name map\n");
+        munmap((void *)data, length);
+        return;
+    }
+    size_t pos = (size_t)names_offset;
+    for (uint32_t i = 1; i <= name_count; i++) {
+        const uint8_t *nul = (pos < length) ? memchr(data + pos, '\0', length - pos) : NULL;
+        if (nul == NULL || (size_t)(nul - (data + pos)) >= MAX_PROCESS_NAME_LENGTH ||
+            (ids[i] = allocator_name(alloc, (const char *)data + pos)) == ALLOCATOR_NO_NAME) {
+            printf("Error: Corrupt binary trace '%s' at offset %zu\n", filename, pos);
+            free(ids);
+            munmap((void *)data, length);
+            return;
+        }
+        pos = (size_t)(nul - data) + 1;
+    }
+    
+    // Replay the records
+    size_t end = (size_t)names_offset;
+    pos = TRACE_HEADER_SIZE;
+    while (pos < end) {
+        size_t record = pos;
+        uint8_t op = data[pos++];
+        size_t id = 0;
+        size_t value = 0;
+        bool valid = true;
+        
+        switch (op) {
+            case TRACE_OP_REQUEST: {
+                valid = read_varint(data, end, &pos, &id) && id >= 1 && id <= name_count &&
+                        read_varint(data, end, &pos, &value) && value > 0 && pos < end;
+                if (!valid) {
+                    break;
+                }
+                uint8_t mode = data[pos++];
+                AllocationStrategy strategy =
+                    (AllocationStrategy)(mode & ~(TRACE_FLAG_COMPACT_ON_FAIL | TRACE_FLAG_ALIGNED));
+                size_t align = 1;
+                if (strategy > STRATEGY_NEXT_FIT ||
+                    ((mode & TRACE_FLAG_ALIGNED) != 0 &&
+                     (!read_varint(data, end, &pos, &align) || align == 0 || (align & (align - 1)) != 0))) {
+                    valid = false;
+                    break;
+                }
+                request_memory(alloc, ids[id], value, align, strategy, (mode & TRACE_FLAG_COMPACT_ON_FAIL) != 0,
+                               false);
+                break;
+            }
+            case TRACE_OP_RESIZE:
+                valid = read_varint(data, end, &pos, &id) && id >= 1 && id <= name_count &&
+                        read_varint(data, end, &pos, &value) && value > 0 && pos < end &&
+                        data[pos] <= STRATEGY_NEXT_FIT;
+                if (valid) {
+                    resize_memory(alloc, ids[id], value, (AllocationStrategy)data[pos++]);
+                }
+                break;
+            case TRACE_OP_RELEASE:
+                valid = read_varint(data, end, &pos, &id) && id >= 1 && id <= name_count;
+                if (valid && allocator_release(alloc, ids[id]) != ALLOCATOR_OK) {
+                    printf("Error: Process '%s' not found\n", allocator_name_string(alloc, ids[id]));
+                }
+                break;
+            case TRACE_OP_COMPACT:
+                allocator_compact(alloc, SIZE_MAX);
+                break;
+            case TRACE_OP_COMPACT_BOUNDED:
+                valid = read_varint(data, end, &pos, &value) && value > 0;
+                if (valid) {
+                    printf("Compaction moved %zu bytes\n", allocator_compact(alloc, value));
+                }
+                break;
+            case TRACE_OP_STAT:
+                valid = pos < end;
+                if (valid) {
+                    allocator_print_statistics(alloc, stdout, data[pos++]);
+                }
+                break;
+            default:
+                valid = false;
+                break;
+        }
+        
+        if (!valid) {
+            printf("Error: Corrupt binary trace '%s' at offset %zu\n", filename, record);
+            break;
+        }
+        sample_ring_tick(ring, alloc);
+    }
+    
+    free(ids);
+    munmap((void *)data, length);
+}
+
+/* ============================================================================
+ * FRAGMENTATION SAMPLING
+ * ============================================================================ */
+
+/**
+ * @brief Prepare an empty sample ring
+ * 
+ * All SAMPLE_RING_CAPACITY slots are allocated up front, so taking a
+ * sample during the replay never allocates or prints.
+ * 
+ * @param ring Ring to initialize
+ * @param interval Commands between samples (non-zero)
+ * @return true on success, false if memory ran out
+ */
+static bool sample_ring_init(SampleRing *ring, size_t interval) {
+    memset(ring, 0, sizeof(SampleRing));
+    ring->samples = (FragmentationSample *)malloc(SAMPLE_RING_CAPACITY * sizeof(FragmentationSample));
+    ring->interval = interval;
+    ring->countdown = interval;
+    return ring->samples != NULL;
+}
+
+/**
+ * @brief Count one replayed command, taking a sample every interval commands
+ * 
+ * The figures come from allocator_get_stats(), which reads counters the
+ * allocator keeps up to date, so this is constant time per command.
+ * 
+ * @param ring Ring to record into (NULL when not sampling)
+ * @param alloc Allocator being replayed
+ */
+static void sample_ring_tick(SampleRing *ring, Allocator *alloc) {
+    if (ring == NULL) {
+        return;
+    }
+    ring->ops++;
+    if (--ring->countdown > 0) {
+        return;
+    }
+    ring->countdown = ring->interval;
+    
+    AllocatorStats stats;
+    allocator_get_stats(alloc, &stats);
+    
+    FragmentationSample *sample = &ring->samples[ring->recorded % SAMPLE_RING_CAPACITY];
+    sample->op = ring->ops;
+    sample->external_fragmentation = stats.external_fragmentation;
+    sample->largest_hole = stats.largest_hole;
+    sample->hole_count = stats.hole_count;
+    sample->total_free = stats.total_free;
+    sample->requests = stats.request_count - ring->last_requests;
+    sample->failed = stats.failed_request_count - ring->last_failed;
+    ring->last_requests = stats.request_count;
+    ring->last_failed = stats.failed_request_count;
+    ring->recorded++;
+}
+
+/**
+ * @brief Print the samples in the ring as CSV, oldest first
+ * 
+ * The failure rate is the percentage of the requests since the previous
+ * sample that found no hole.
+ * 
+ * @param ring Ring to print
+ * @param out Stream to write to
+ */
+static void sample_ring_dump(const SampleRing *ring, FILE *out) {
+    size_t kept = (ring->recorded < SAMPLE_RING_CAPACITY) ? ring->recorded : SAMPLE_RING_CAPACITY;
+    size_t first = ring->recorded - kept;
+    
+    fprintf(out, "Samples: %zu taken every %zu commands", ring->recorded, ring->interval);
+    if (first > 0) {
+        fprintf(out, ", oldest %zu overwritten", first);
+    }
+    fprintf(out, "\n");
+    fprintf(out, "op,external_fragmentation,largest_hole,hole_count,total_free,requests,failed,failure_rate\n");
+    for (size_t i = first; i < ring->recorded; i++) {
+        const FragmentationSample *sample = &ring->samples[i % SAMPLE_RING_CAPACITY];
+        double failure_rate = (sample->requests > 0) ? 100.0 * (double)sample->failed / (double)sample->requests : 0.0;
+        fprintf(out, "%zu,%.1f,%zu,%zu,%zu,%zu,%zu,%.1f\n",
+                sample->op, sample->external_fragmentation, sample->largest_hole, sample->hole_count,
+                sample->total_free, sample->requests, sample->failed, failure_rate);
+    }
+}
+
+/**
+ * @brief Free the samples of a ring
+ * 
+ * @param ring Ring to free
+ */
+static void sample_ring_free(SampleRing *ring) {
+    free(ring->samples);
+    ring->samples = NULL;
+}
+
+/* ============================================================================
+ * BENCHMARK
+ * ============================================================================ */
+
+/**
+ * @brief Advance a xorshift64* generator
+ * 
+ * @param state Generator state (never zero)
+ * @return Next pseudo-random value
+ */
+static uint64_t bench_random(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545f4914f6cdd1dULL;
+}
+
+/**
+ * @brief Draw a request size from a workload's size distribution
+ * 
+ * @param sizes Size distribution
+ * @param state Generator state
+ * @return Request size in bytes
+ */
+static size_t bench_size(BenchSizeDistribution sizes, uint64_t *state) {
+    uint64_t r = bench_random(state);
+    switch (sizes) {
+        case BENCH_SIZES_POWER_LAW: {
+            // Range [2^k, 2^(k+1)) for k = 4..19, each half as likely as the one below
+            int k = 4 + __builtin_ctzll((r >> 32) | (1ULL << 15));
+            return ((size_t)1 << k) + (size_t)(r % ((uint64_t)1 << k));
+        }
+        case BENCH_SIZES_BIMODAL:
+            if (r % 10 != 0) {
+                return 16 + (size_t)((r >> 8) % 241);
+            }
+            return ((size_t)64 << 10) + (size_t)((r >> 8) % ((192 << 10) + 1));
+        case BENCH_SIZES_UNIFORM:
+        default:
+            return 1 + (size_t)(r % (16 << 10));
+    }
+}
+
+/**
+ * @brief Order a pair of latencies for qsort
+ */
+static int compare_latency(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Nanoseconds elapsed between two monotonic clock readings
+ */
+static uint64_t elapsed_ns(const struct timespec *from, const struct timespec *to) {
+    return (uint64_t)(to->tv_sec - from->tv_sec) * 1000000000ULL + (uint64_t)to->tv_nsec - (uint64_t)from->tv_nsec;
+}
+
+/**
+ * @brief Replay one synthetic workload against a fresh allocator
+ * 
+ * Calls allocator_request() and allocator_release() directly, so nothing is
+ * parsed or printed. Each step allocates with probability 0.6 while less
+ * than half the heap is requested and 0.4 otherwise, which holds the heap
+ * around half full; releases pick their victim by the lifetime policy.
+ * Only the calls themselves are timed; names are interned beforehand.
+ * 
+ * @param memory_size Heap size
+ * @param index_mode Hole index to use
+ * @param sizes Request size distribution
+ * @param lifetime Release order
+ * @param strategy Strategy for every request
+ * @param result Output: measurements
+ * @return 0 on success, -1 if the benchmark ran out of memory
+ */
+static int run_benchmark(size_t memory_size, HoleIndexMode index_mode, BenchSizeDistribution sizes,
+                         BenchLifetime lifetime, AllocationStrategy strategy, BenchResult *result) {
+    uint64_t *latency = (uint64_t *)malloc(BENCH_OPS * sizeof(uint64_t));
+    size_t capacity = 1024;
+    AllocatorName *live = (AllocatorName *)malloc(capacity * sizeof(AllocatorName)); // Ring buffer, oldest at head
+    size_t *live_sizes = (size_t *)malloc(capacity * sizeof(size_t));
+    Allocator *alloc = allocator_create(memory_size, index_mode);
+    if (latency == NULL || live == NULL || live_sizes == NULL || alloc == NULL) {
+        free(latency);
+        free(live);
+        free(live_sizes);
+        allocator_destroy(alloc);
+        return -1;
+    }
+    
+    uint64_t state = BENCH_SEED;
+    size_t head = 0;
+    size_t count = 0;
+    size_t live_bytes = 0;
+    uint64_t total_ns = 0;
+    int status = 0;
+    memset(result, 0, sizeof(BenchResult));
+    
+    for (size_t op = 0; op < BENCH_OPS; op++) {
+        uint64_t r = bench_random(&state) % 10;
+        bool allocate = (count == 0) || r < ((live_bytes < memory_size / 2) ? 6u : 4u);
+        struct timespec t0, t1;
+        
+        if (allocate) {
+            char name[MAX_PROCESS_NAME_LENGTH];
+            snprintf(name, sizeof(name), "b%zu", op);
+            AllocatorName id = allocator_name(alloc, name);
+            if (id == ALLOCATOR_NO_NAME) {
+                status = -1;
+                break;
+            }
+            if (count == capacity) {
+                // Grow the ring, unwrapping it so the oldest entry is first again
+                AllocatorName *grown = (AllocatorName *)malloc(2 * capacity * sizeof(AllocatorName));
+                size_t *grown_sizes = (size_t *)malloc(2 * capacity * sizeof(size_t));
+                if (grown == NULL || grown_sizes == NULL) {
+                    free(grown);
+                    free(grown_sizes);
+                    status = -1;
+                    break;
+                }
+                for (size_t k = 0; k < count; k++) {
+                    grown[k] = live[(head + k) % capacity];
+                    grown_sizes[k] = live_sizes[(head + k) % capacity];
+                }
+                free(live);
+                free(live_sizes);
+                live = grown;
+                live_sizes = grown_sizes;
+                capacity *= 2;
+                head = 0;
+            }
+            size_t size = bench_size(sizes, &state);
+            
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            AllocatorStatus outcome = allocator_request(alloc, id, size, strategy, false, NULL);
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            
+            if (outcome == ALLOCATOR_OK) {
+                live[(head + count) % capacity] = id;
+                live_sizes[(head + count) % capacity] = size;
+                count++;
+                live_bytes += size;
+            } else {
+                result->failed++;
+            }
+        } else {
+            // Move the victim to one end of the ring and take it from there
+            size_t slot;
+            if (lifetime == BENCH_LIFETIME_LIFO) {
+                slot = (head + count - 1) % capacity;
+            } else {
+                if (lifetime == BENCH_LIFETIME_RANDOM) {
+                    size_t victim = (head + (size_t)(bench_random(&state) % count)) % capacity;
+                    AllocatorName swap = live[victim];
+                    size_t swap_size = live_sizes[victim];
+                    live[victim] = live[head];
+                    live_sizes[victim] = live_sizes[head];
+                    live[head] = swap;
+                    live_sizes[head] = swap_size;
+                }
+                slot = head;
+                head = (head + 1) % capacity;
+            }
+            AllocatorName id = live[slot];
+            count--;
+            live_bytes -= live_sizes[slot];
+            
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            allocator_release(alloc, id);
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+        }
+        
+        latency[op] = elapsed_ns(&t0, &t1);
+        total_ns += latency[op];
+        result->ops++;
+    }
+    
+    if (status == 0) {
+        qsort(latency, result->ops, sizeof(uint64_t), compare_latency);
+        result->ops_per_sec = (total_ns > 0) ? (double)result->ops * 1e9 / (double)total_ns : 0.0;
+        result->p50_ns = latency[(result->ops * 500 + 999) / 1000 - 1];
+        result->p99_ns = latency[(result->ops * 990 + 999) / 1000 - 1];
+        result->p999_ns = latency[(result->ops * 999 + 999) / 1000 - 1];
+        AllocatorStats stats;
+        allocator_get_stats(alloc, &stats);
+        result->peak_blocks = stats.peak_block_count;
+    }
+    
+    allocator_destroy(alloc);
+    free(latency);
+    free(live);
+    free(live_sizes);
+    return status;
+}
+
+/**
+ * @brief Run every workload with F, B and W and report the results
+ * 
+ * Crosses the uniform, power-law and bimodal size distributions with
+ * random, LIFO and FIFO lifetimes. Results are printed as a table and
+ * written to a CSV file with one row per (workload, strategy) run.
+ * 
+ * @param csv_file Path of the CSV file to write
+ * @param memory_size Heap size of each run
+ * @param index_mode Hole index to use
+ * @return 0 on success, -1 on error
+ */
+static int run_benchmarks(const char *csv_file, size_t memory_size, HoleIndexMode index_mode) {
+    static const char *const size_names[] = {"uniform", "power-law", "bimodal"};
+    static const char *const lifetime_names[] = {"random", "lifo", "fifo"};
+    static const char *const index_names[] = {"list", "seg", "tree"};
+    static const char strategy_names[] = "FBW";
+    
+    FILE *csv = fopen(csv_file, "w");
+    if (csv == NULL) {
+        fprintf(stderr, "Error: Cannot create file '%s'\n", csv_file);
+        return -1;
+    }
+    fprintf(csv, "sizes,lifetime,strategy,index,memory,ops,failed,ops_per_sec,p50_ns,p99_ns,p999_ns,peak_blocks\n");
+    
+    printf("Benchmark: %d operations per run, %zu-byte heap, %s index\n",
+           BENCH_OPS, memory_size, index_names[index_mode]);
+    printf("%-10s %-8s %-8s %12s %8s %8s %9s %8s %11s\n",
+           "Sizes", "Lifetime", "Strategy", "Ops/sec", "p50 ns", "p99 ns", "p99.9 ns", "Failed", "Peak blocks");
+    
+    int status = 0;
+    for (int sizes = BENCH_SIZES_UNIFORM; sizes <= BENCH_SIZES_BIMODAL && status == 0; sizes++) {
+        for (int lifetime = BENCH_LIFETIME_RANDOM; lifetime <= BENCH_LIFETIME_FIFO && status == 0; lifetime++) {
+            for (int strategy = STRATEGY_FIRST_FIT; strategy <= STRATEGY_WORST_FIT; strategy++) {
+                BenchResult result;
+                if (run_benchmark(memory_size, index_mode, (BenchSizeDistribution)sizes,
+                                  (BenchLifetime)lifetime, (AllocationStrategy)strategy, &result) != 0) {
+                    fprintf(stderr, "Error: Benchmark ran out of memory\n");
+                    status = -1;
+                    break;
+                }
+                printf("%-10s %-8s %-8c %12.0f %8llu %8llu %9llu %8zu %11zu\n",
+                       size_names[sizes], lifetime_names[lifetime], strategy_names[strategy],
+                       result.ops_per_sec, (unsigned long long)result.p50_ns,
+                       (unsigned long long)result.p99_ns, (unsigned long long)result.p999_ns,
+                       result.failed, result.peak_blocks);
+                fprintf(csv, "%s,%s,%c,%s,%zu,%zu,%zu,%.0f,%llu,%llu,%llu,%zu\n",
+                        size_names[sizes], lifetime_names[lifetime], strategy_names[strategy],
+                        index_names[index_mode], memory_size, result.ops, result.failed,
+                        result.ops_per_sec, (unsigned long long)result.p50_ns,
+                        (unsigned long long)result.p99_ns, (unsigned long long)result.p999_ns,
+                        result.peak_blocks);
+                fflush(stdout);
+            }
+        }
+    }
+    
+    if (fclose(csv) != 0 && status == 0) {
+        fprintf(stderr, "Error: Failed to write '%s'\n", csv_file);
+        status = -1;
+    }
+    if (status == 0) {
+        printf("Results written to '%s'\n", csv_file);
+    }
+    return status;
+}
+/**
+ * @brief Body of one contention benchmark thread
+ * 
+ * Cycles through BENCH_THREAD_LIVE process slots of its own, picked at
+ * random: an empty slot is filled with a request from the bimodal size
+ * distribution, mostly small, and a held one is released. The thread waits at the barrier before its first call.
+ * 
+ * @param arg The thread's BenchThread
+ * @return NULL
+ */
+static void *bench_thread_main(void *arg) {
+    BenchThread *thread = (BenchThread *)arg;
+    char names[BENCH_THREAD_LIVE][MAX_PROCESS_NAME_LENGTH];
+    ArenaBlock blocks[BENCH_THREAD_LIVE];
+    bool held[BENCH_THREAD_LIVE] = {false};
+    uint64_t state = ((BENCH_SEED ^ thread->index) * 0xbf58476d1ce4e5b9ULL) | 1; // Never zero
+    
+    for (unsigned slot = 0; slot < BENCH_THREAD_LIVE; slot++) {
+        snprintf(names[slot], sizeof(names[slot]), "t%u_%u", thread->index, slot);
+    }
+    
+    pthread_barrier_wait(thread->start);
+    for (size_t op = 0; op < BENCH_THREAD_OPS; op++) {
+        unsigned slot = (unsigned)(bench_random(&state) % BENCH_THREAD_LIVE);
+        if (held[slot]) {
+            arena_allocator_release(thread->arenas, &blocks[slot]);
+            held[slot] = false;
+        } else {
+            size_t size = bench_size(BENCH_SIZES_BIMODAL, &state);
+            held[slot] = arena_allocator_request(thread->arenas, names[slot], size,
+                                                 STRATEGY_FIRST_FIT, &blocks[slot]) == ALLOCATOR_OK;
+            thread->failed += !held[slot];
+        }
+        thread->ops++;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Run the contention workload with a number of threads and arenas
+ * 
+ * All threads start together at a barrier; the run is timed from there
+ * until the last thread finishes.
+ * 
+ * @param memory_size Heap size, split between the arenas
+ * @param index_mode Hole index of every arena
+ * @param threads Number of threads (1 to BENCH_MAX_THREADS)
+ * @param arena_count Number of arenas
+ * @param thread_cache Whether small requests go through the thread caches
+ * @param result Output: measurements
+ * @return 0 on success, -1 if the allocator or a thread could not be created
+ */
+static int run_thread_benchmark(size_t memory_size, HoleIndexMode index_mode, unsigned threads,
+                                unsigned arena_count, bool thread_cache, ThreadBenchResult *result) {
+    ArenaAllocator *arenas = arena_allocator_create(memory_size, arena_count, index_mode);
+    if (arenas == NULL) {
+        return -1;
+    }
+    arena_allocator_set_thread_cache(arenas, thread_cache);
+    
+    pthread_t ids[BENCH_MAX_THREADS];
+    BenchThread work[BENCH_MAX_THREADS];
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, NULL, threads + 1);
+    
+    unsigned started = 0;
+    for (; started < threads; started++) {
+        work[started] = (BenchThread){arenas, &start, started, 0, 0};
+        if (pthread_create(&ids[started], NULL, bench_thread_main, &work[started]) != 0) {
+            break;
+        }
+    }
+    if (started < threads) {
+        // The barrier can never fill; the threads already started are left
+        // blocked on it, so give up on the whole benchmark
+        fprintf(stderr, "Error: Failed to start benchmark thread %u\n", started);
+        exit(EXIT_FAILURE);
+    }
+    
+    struct timespec t0, t1;
+    pthread_barrier_wait(&start);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (unsigned i = 0; i < threads; i++) {
+        pthread_join(ids[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    
+    ArenaStats stats;
+    arena_allocator_get_stats(arenas, &stats);
+    memset(result, 0, sizeof(ThreadBenchResult));
+    for (unsigned i = 0; i < threads; i++) {
+        result->ops += work[i].ops;
+        result->failed += work[i].failed;
+    }
+    result->steals = stats.steal_count;
+    result->cache_hits = stats.cache_hits;
+    result->cache_misses = stats.cache_misses;
+    uint64_t total_ns = elapsed_ns(&t0, &t1);
+    result->ops_per_sec = (total_ns > 0) ? (double)result->ops * 1e9 / (double)total_ns : 0.0;
+    
+    pthread_barrier_destroy(&start);
+    arena_allocator_destroy(arenas);
+    return 0;
+}
+
+/**
+ * @brief Measure how the arena allocator scales from 1 to 32 threads
+ * 
+ * Each thread count is run three times: with a single arena, where every
+ * call takes the same lock, with one arena per thread, and with one arena
+ * per thread behind the thread caches. Results are printed as a table,
+ * with the speed-up over one thread, and written to a CSV file.
+ * 
+ * @param csv_file Path of the CSV file to write
+ * @param memory_size Heap size of each run
+ * @param index_mode Hole index to use
+ * @return 0 on success, -1 on error
+ */
+static int run_thread_benchmarks(const char *csv_file, size_t memory_size, HoleIndexMode index_mode) {
+    static const char *const index_names[] = {"list", "seg", "tree"};
+    
+    FILE *csv = fopen(csv_file, "w");
+    if (csv == NULL) {
+        fprintf(stderr, "Error: Cannot create file '%s'\n", csv_file);
+        return -1;
+    }
+    fprintf(csv, "threads,arenas,cache,index,memory,ops,failed,steals,cache_hits,cache_misses,ops_per_sec\n");
+    
+    printf("Contention benchmark: %d operations per thread, %zu-byte heap, %s index\n",
+           BENCH_THREAD_OPS, memory_size, index_names[index_mode]);
+    printf("%-8s %-7s %-6s %12s %8s %8s %8s %7s\n",
+           "Threads", "Arenas", "Cache", "Ops/sec", "Speed-up", "Steals", "Failed", "Hit %");
+    
+    int status = 0;
+    for (int config = 0; config <= 2 && status == 0; config++) {
+        bool thread_cache = (config == 2);
+        double baseline = 0.0;
+        for (unsigned threads = 1; threads <= BENCH_MAX_THREADS; threads *= 2) {
+            unsigned arena_count = (config == 0) ? 1 : threads;
+            ThreadBenchResult result;
+            if (run_thread_benchmark(memory_size, index_mode, threads, arena_count, thread_cache, &result) != 0) {
+                fprintf(stderr, "Error: Cannot split %zu bytes into %u arenas\n", memory_size, arena_count);
+                status = -1;
+                break;
+            }
+            if (threads == 1) {
+                baseline = result.ops_per_sec;
+            }
+            size_t lookups = result.cache_hits + result.cache_misses;
+            printf("%-8u %-7u %-6s %12.0f %7.2fx %8zu %8zu %6.2f%%\n", threads, arena_count,
+                   thread_cache ? "on" : "off", result.ops_per_sec,
+                   (baseline > 0.0) ? result.ops_per_sec / baseline : 0.0, result.steals, result.failed,
+                   (lookups > 0) ? 100.0 * (double)result.cache_hits / (double)lookups : 0.0);
+            fprintf(csv, "%u,%u,%s,%s,%zu,%zu,%zu,%zu,%zu,%zu,%.0f\n", threads, arena_count,
+                    thread_cache ? "on" : "off", index_names[index_mode], memory_size, result.ops,
+                    result.failed, result.steals, result.cache_hits, result.cache_misses, result.ops_per_sec);
+            fflush(stdout);
+        }
+    }
+    
+    if (fclose(csv) != 0 && status == 0) {
+        fprintf(stderr, "Error: Failed to write '%s'\n", csv_file);
+        status = -1;
+    }
+    if (status == 0) {
+        printf("Results written to '%s'\n", csv_file);
+    }
+    return status;
+}
+
+/* ============================================================================
+ * STRATEGY COMPARISON
+ * ============================================================================ */
+
+/**
+ * @brief Parse a text trace into batch operations
+ * 
+ * Names are interned into alloc, so the ids stay valid in every copy made
+ * of it afterwards. STAT lines are skipped.
+ * 
+ * @param alloc Allocator to intern process names into
+ * @param filename Path of the text trace
+ * @param count Output: number of operations
+ * @return The operations (free with free()), or NULL on error
+ */
+static AllocatorOp *load_trace_ops(Allocator *alloc, const char *filename, size_t *count) {
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) {
+        printf("Error: Cannot open file '%s'\n", filename);
+        return NULL;
+    }
+    
+    size_t capacity = 1024;
+    AllocatorOp *ops = (AllocatorOp *)malloc(capacity * sizeof(AllocatorOp));
+    char line[MAX_LINE_LENGTH];
+    size_t line_number = 0;
+    int read;
+    *count = 0;
+    
+    while (ops != NULL && (read = read_line(file, line, sizeof(line))) != 0) {
+        line_number++;
+        if (read < 0) {
+            printf("Error: %s:%zu: Line longer than %d characters\n", filename, line_number, MAX_LINE_LENGTH - 1);
+            free(ops);
+            fclose(file);
+            return NULL;
+        }
+        trim_whitespace(line);
+        if (strlen(line) == 0 || line[0] == '#') {
+            continue;
+        }
+        
+        AllocatorOp op;
+        TraceOpcode opcode = parse_trace_line(line, alloc, &op, stdout, filename, line_number);
+        if (opcode == 0) {
+            free(ops);
+            fclose(file);
+            return NULL;
+        }
+        if (opcode == TRACE_OP_STAT) {
+            continue;
+        }
+        
+        if (*count == capacity) {
+            capacity *= 2;
+            AllocatorOp *grown = (AllocatorOp *)realloc(ops, capacity * sizeof(AllocatorOp));
+            if (grown == NULL) {
+                free(ops);
+                ops = NULL;
+                break;
+            }
+            ops = grown;
+        }
+        ops[(*count)++] = op;
+    }
+    
+    fclose(file);
+    if (ops == NULL) {
+        printf("Error: Failed to allocate trace buffer\n");
+    }
+    return ops;
+}
+
+/**
+ * @brief Replay a compared trace on one strategy's allocator
+ * 
+ * @param arg The strategy's CompareRun
+ * @return NULL
+ */
+static void *compare_thread_main(void *arg) {
+    CompareRun *run = (CompareRun *)arg;
+    struct timespec t0, t1;
+    
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    allocator_apply_batch(run->alloc, run->ops, run->count, run->results);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    run->elapsed_ns = elapsed_ns(&t0, &t1);
+    
+    for (size_t i = 0; i < run->count; i++) {
+        run->bytes_moved += run->results[i].bytes_moved;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Replay one text trace under every strategy side by side
+ * 
+ * The trace is parsed once. Each strategy then gets its own copy of the
+ * current allocator state (see allocator_clone()) and of the operations,
+ * with every request switched to that strategy, and replays them in its
+ * own thread. The REPL allocator itself is left as it was, apart from
+ * interning the trace's names. Nothing is printed per command; the
+ * outcome is one table row per strategy.
+ * 
+ * @param alloc Allocator whose state every strategy starts from
+ * @param filename Path of the text trace
+ */
+static void compare_strategies(Allocator *alloc, const char *filename) {
+    static const struct {
+        AllocationStrategy strategy;
+        const char *name;
+    } strategies[] = {
+        {STRATEGY_FIRST_FIT, "First fit"},
+        {STRATEGY_BEST_FIT, "Best fit"},
+        {STRATEGY_WORST_FIT, "Worst fit"},
+        {STRATEGY_BUDDY, "Buddy"},
+        {STRATEGY_TLSF, "TLSF"},
+        {STRATEGY_NEXT_FIT, "Next fit"}
+    };
+    enum { STRATEGY_COUNT = sizeof(strategies) / sizeof(strategies[0]) };
+    
+    size_t count;
+    AllocatorOp *ops = load_trace_ops(alloc, filename, &count);
+    if (ops == NULL) {
+        return;
+    }
+    
+    AllocatorStats before;
+    allocator_get_stats(alloc, &before);
+    
+    // Every copy is made before any thread starts, so alloc is only read
+    CompareRun runs[STRATEGY_COUNT];
+    memset(runs, 0, sizeof(runs));
+    bool ready = true;
+    for (int i = 0; i < STRATEGY_COUNT && ready; i++) {
+        CompareRun *run = &runs[i];
+        run->count = count;
+        run->alloc = allocator_clone(alloc);
+        run->ops = (AllocatorOp *)malloc((count + 1) * sizeof(AllocatorOp));
+        run->results = (AllocatorResult *)malloc((count + 1) * sizeof(AllocatorResult));
+        ready = run->alloc != NULL && run->ops != NULL && run->results != NULL;
+        for (size_t j = 0; ready && j < count; j++) {
+            run->ops[j] = ops[j];
+            run->ops[j].strategy = strategies[i].strategy;
+        }
+    }
+    free(ops);
+    
+    pthread_t ids[STRATEGY_COUNT];
+    int started = 0;
+    for (; ready && started < STRATEGY_COUNT; started++) {
+        if (pthread_create(&ids[started], NULL, compare_thread_main, &runs[started]) != 0) {
+            break;
+        }
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(ids[i], NULL);
+    }
+    if (!ready) {
+        printf("Error: Failed to allocate strategy copies\n");
+    } else if (started < STRATEGY_COUNT) {
+        printf("Error: Failed to start comparison thread\n");
+    } else {
+        printf("Strategy comparison: %zu commands from '%s'\n", count, filename);
+        printf("%-10s %8s %8s %9s %13s %7s %10s %10s %7s %9s\n", "Strategy", "Requests", "Failed",
+               "Ext frag", "Largest hole", "Holes", "Int waste", "Moved", "Probes", "Time ms");
+        for (int i = 0; i < STRATEGY_COUNT; i++) {
+            AllocatorStats stats;
+            allocator_get_stats(runs[i].alloc, &stats);
+            AllocationStrategy strategy = strategies[i].strategy;
+            size_t searches = stats.searches[strategy] - before.searches[strategy];
+            size_t probes = stats.probes[strategy] - before.probes[strategy];
+            printf("%-10s %8zu %8zu %8.2f%% %13zu %7zu %10zu %10zu %7.1f %9.3f\n", strategies[i].name,
+                   stats.request_count - before.request_count,
+                   stats.failed_request_count - before.failed_request_count,
+                   stats.external_fragmentation, stats.largest_hole, stats.hole_count,
+                   stats.internal_waste, runs[i].bytes_moved,
+                   searches > 0 ? (double)probes / (double)searches : 0.0,
+                   (double)runs[i].elapsed_ns / 1e6);
+        }
+    }
+    
+    for (int i = 0; i < STRATEGY_COUNT; i++) {
+        allocator_destroy(runs[i].alloc);
+        free(runs[i].ops);
+        free(runs[i].results);
+    }
+}
+
+/* ============================================================================
+ * UTILITY FUNCTIONS
+ * ============================================================================ */
+
+/**
+ * @brief Parse a size string (supports KB, MB, GB and TB suffixes)
+ * 
+ * Suffixes are binary (KB = 1024 bytes) and case-insensitive, and the
+ * trailing B may be left out. The whole string must be used.
+ * 
+ * @param str String to parse
+ * @return Size in bytes, or 0 on error or if it does not fit in a size_t
+ */
+static size_t parse_size(const char *str) {
+    static const char *const suffixes[] = {"K", "M", "G", "T"};
+    
+    if (str == NULL || !isdigit((unsigned char)str[0])) {
+        return 0;
+    }
+    
+    char *endptr;
+    errno = 0;
+    unsigned long long value = strtoull(str, &endptr, 10);
+    if (errno == ERANGE || value > SIZE_MAX) {
+        return 0;
+    }
+    
+    // Check for suffix
+    while (*endptr == ' ' || *endptr == '\t') {
+        endptr++;
+    }
+    
+    if (*endptr == '\0') {
+        // No suffix - assume bytes
+        return (size_t)value;
+    }
+    
+    for (int i = 0; i < 4; i++) {
+        if (toupper((unsigned char)endptr[0]) == suffixes[i][0] &&
+            (endptr[1] == '\0' || (toupper((unsigned char)endptr[1]) == 'B' && endptr[2] == '\0'))) {
+            int shift = 10 * (i + 1);
+            return (value <= (SIZE_MAX >> shift)) ? (size_t)value << shift : 0;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Read one line, without its newline
+ * 
+ * A line that does not fit in the buffer is read to its end and
+ * discarded, so it can never be taken for two shorter commands.
+ * 
+ * @param file Stream to read from
+ * @param line Buffer for the line
+ * @param size Size of the buffer
+ * @return 1 if a line was read, -1 if it was too long, 0 at end of file
+ */
+static int read_line(FILE *file, char *line, size_t size) {
+    if (fgets(line, (int)size, file) == NULL) {
+        return 0;
+    }
+    
+    size_t len = strlen(line);
+    if (len > 0 && line[len - 1] == '\n') {
+        line[len - 1] = '\0';
+        return 1;
+    }
+    if (len + 1 < size || feof(file)) {
+        return 1; // Last line of the file, without a newline
+    }
+    
+    int c;
+    while ((c = getc(file)) != EOF && c != '\n') {
+    }
+    line[0] = '\0';
+    return -1;
+}
+
+/**
+ * @brief Trim leading and trailing whitespace from a string
+ * 
+ * @param str String to trim (modified in place)
+ */
+static void trim_whitespace(char *str) {
+    if (str == NULL) {
+        return;
+    }
+    
+    // Trim leading whitespace
+    char *start = str;
+    while (*start == ' ' || *start == '\t' || *start == '\n' || *start == '\r') {
+        start++;
+    }
+    
+    // Trim trailing whitespace
+    char *end = start + strlen(start) - 1;
+    while (end > start && (*end == ' ' || *end == '\t' || *end == '\n' || *end == '\r')) {
+        *end = '\0';
+        end--;
+    }
+    
+    // Move trimmed string to beginning
+    if (start != str) {
+        memmove(str, start, strlen(start) + 1);
+    }
+}